@@ -0,0 +1,95 @@
+/****************************************************************************************************************************
+   examples/ESP32_FrameSync.ino
+   For ESP32 boards
+   Written by Khoi Hoang
+
+   Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+   Licensed under MIT license
+
+   Frame-synchronous control loop: a task registered with setFrameNotify() is woken by the ISR at the start of each
+   20ms frame, computes the new set points and calls setPosition(), which lands in the next frame. No polling with
+   millis(), the actuation latency is one frame at most. The servo follows a potentiometer, through a low-pass filter
+*****************************************************************************************************************************/
+
+#ifndef ESP32
+	#error This code is designed to run on ESP32 platform, not Arduino nor ESP8266! Please check your Tools->Board setting.
+#endif
+
+#define TIMER_INTERRUPT_DEBUG       0
+#define ISR_SERVO_DEBUG             1
+
+// Select different ESP32 timer number (0-3) to avoid conflict
+#define USE_ESP32_TIMER_NO          3
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_ISR_Servo.h"
+
+// Published values for SG90 servos; adjust if needed
+#define MIN_MICROS      800  //544
+#define MAX_MICROS      2450
+
+#define SERVO_PIN       4
+#define POT_PIN         34
+
+int8_t servoIndex = -1;
+
+volatile uint32_t missedFrames = 0;
+
+// Wakes once per frame, aligned to its start
+void controlTask(void* param)
+{
+	float position = 90;
+
+	ESP32_ISR_Servos.setFrameNotify();
+
+	while (true)
+	{
+		// Frames started since the last wake up, more than 1 if this task was late
+		uint32_t frames = ESP32_ISR_Servos.waitFrame();
+
+		if (frames > 1)
+			missedFrames += frames - 1;
+
+		float target = analogRead(POT_PIN) * 180.0f / 4095;
+
+		position += (target - position) * 0.2f;
+
+		ESP32_ISR_Servos.setPosition(servoIndex, position);
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ESP32_FrameSync on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_ISR_SERVO_VERSION);
+
+	//Select ESP32 timer USE_ESP32_TIMER_NO
+	ESP32_ISR_Servos.useTimer(USE_ESP32_TIMER_NO);
+
+	servoIndex = ESP32_ISR_Servos.setupServo(SERVO_PIN, MIN_MICROS, MAX_MICROS);
+
+	if (servoIndex == -1)
+	{
+		Serial.println(F("Setup Servo failed"));
+
+		return;
+	}
+
+	// Higher priority than loop(), woken right at the end of the ISR
+	xTaskCreatePinnedToCore(controlTask, "control", 4096, NULL, 5, NULL, 0);
+}
+
+void loop()
+{
+	Serial.print(F("Position = ")); Serial.print(ESP32_ISR_Servos.getPosition(servoIndex));
+	Serial.print(F(", missed frames = ")); Serial.println(missedFrames);
+
+	delay(2000);
+}
@@ -0,0 +1,111 @@
+/****************************************************************************************************************************
+   examples/ESP32_ISR_MultiEngines.ino
+   For ESP32 boards
+   Written by Khoi Hoang
+
+   Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+   Licensed under MIT license
+
+   Up to 32 servos split across two engines, each with its own hardware timer and ISR:
+   - the default ESP32_ISR_Servos on timer 3, with its ISR on the core running setup() (core 1)
+   - armServos on timer 1, with its ISR on core 0, as its first setupServo() is called from a task pinned to core 0
+   The LEDC and RMT channels (ISR_SERVO_LEDC_CHANNELS, ISR_SERVO_RMT_CHANNELS) are shared by both engines
+*****************************************************************************************************************************/
+
+#ifndef ESP32
+	#error This code is designed to run on ESP32 platform, not Arduino nor ESP8266! Please check your Tools->Board setting.
+#endif
+
+#define TIMER_INTERRUPT_DEBUG       0
+#define ISR_SERVO_DEBUG             1
+
+// Timer of the default ESP32_ISR_Servos engine
+#define USE_ESP32_TIMER_NO          3
+
+// Timer of the second engine, must be different
+#define ARM_ESP32_TIMER_NO          1
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_ISR_Servo.h"
+
+// Published values for SG90 servos; adjust if needed
+#define MIN_MICROS      800  //544
+#define MAX_MICROS      2450
+
+#define NUM_SERVOS      8
+
+// Second engine, sized for its NUM_SERVOS servos only. Its timer interrupt is allocated by its first setupServo()
+ESP32_ISR_ServoT<NUM_SERVOS> armServos(ARM_ESP32_TIMER_NO);
+
+uint8_t baseServoPins[NUM_SERVOS] = { 4, 5, 12, 13, 14, 15, 16, 17 };
+uint8_t armServoPins[NUM_SERVOS]  = { 18, 19, 21, 22, 23, 25, 26, 27 };
+
+int     baseServoIndex[NUM_SERVOS];
+int     armServoIndex[NUM_SERVOS];
+
+volatile bool armReady = false;
+
+// Runs on core 0 => ISR of armServos on core 0
+void armSetupTask(void* param)
+{
+	(void) param;
+
+	for (int index = 0; index < NUM_SERVOS; index++)
+	{
+		armServoIndex[index] = armServos.setupServo(armServoPins[index], MIN_MICROS, MAX_MICROS);
+	}
+
+	armReady = true;
+
+	vTaskDelete(NULL);
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ESP32_ISR_MultiEngines on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_ISR_SERVO_VERSION);
+
+	//Select ESP32 timer USE_ESP32_TIMER_NO
+	ESP32_ISR_Servos.useTimer(USE_ESP32_TIMER_NO);
+
+	for (int index = 0; index < NUM_SERVOS; index++)
+	{
+		baseServoIndex[index] = ESP32_ISR_Servos.setupServo(baseServoPins[index], MIN_MICROS, MAX_MICROS);
+	}
+
+	xTaskCreatePinnedToCore(armSetupTask, "armSetup", 4096, NULL, 1, NULL, 0);
+
+	while (!armReady)
+		delay(10);
+
+	Serial.print(F("Servos on timer ")); Serial.print(USE_ESP32_TIMER_NO);
+	Serial.print(F(" = ")); Serial.print(ESP32_ISR_Servos.getNumServos());
+	Serial.print(F(", on timer ")); Serial.print(ARM_ESP32_TIMER_NO);
+	Serial.print(F(" = ")); Serial.println(armServos.getNumServos());
+}
+
+void loop()
+{
+	int position;      // position in degrees
+
+	for (position = 0; position <= 180; position += 5)
+	{
+		// Each engine is a single producer: set them from one task at a time
+		for (int index = 0; index < NUM_SERVOS; index++)
+		{
+			ESP32_ISR_Servos.setPosition(baseServoIndex[index], position);
+			armServos.setPosition(armServoIndex[index], 180 - position);
+		}
+
+		delay(200);
+	}
+
+	delay(2000);
+}
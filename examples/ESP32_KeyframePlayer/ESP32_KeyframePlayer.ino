@@ -0,0 +1,99 @@
+/****************************************************************************************************************************
+   examples/ESP32_KeyframePlayer.ino
+   For ESP32 boards
+   Written by Khoi Hoang
+
+   Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+   Licensed under MIT license
+
+   Choreographed motion with playSequence(): keyframes (time, servo mask, positions) stay in flash and are interpolated
+   by the engine once per 20ms frame, looping at any speed. A small task on core 0 calls updateMotion(),
+   leaving loop() on core 1 free for the application
+*****************************************************************************************************************************/
+
+#ifndef ESP32
+	#error This code is designed to run on ESP32 platform, not Arduino nor ESP8266! Please check your Tools->Board setting.
+#endif
+
+#define TIMER_INTERRUPT_DEBUG       0
+#define ISR_SERVO_DEBUG             1
+
+// Select different ESP32 timer number (0-3) to avoid conflict
+#define USE_ESP32_TIMER_NO          3
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_ISR_Servo.h"
+
+// Published values for SG90 servos; adjust if needed
+#define MIN_MICROS      800  //544
+#define MAX_MICROS      2450
+
+#define NUM_SERVOS      3
+
+uint8_t servoPins[NUM_SERVOS]   = { 4, 5, 18 };
+
+// Wave of 3 servos over 3s, in flash. Servos are set up in order, servoIndex 0, 1, 2 => mask bits 0, 1, 2
+const uint8_t wave[] =
+{
+	ISR_SERVO_KEYFRAME(0,     0x07),  90, 90, 90,
+	ISR_SERVO_KEYFRAME(500,   0x01),  160,
+	ISR_SERVO_KEYFRAME(1000,  0x03),  20,  160,
+	ISR_SERVO_KEYFRAME(1500,  0x06),  20,  160,
+	ISR_SERVO_KEYFRAME(2000,  0x05),  90,  20,
+	ISR_SERVO_KEYFRAME(3000,  0x07),  90, 90, 90
+};
+
+// Only task calling the servo setters once started
+void motionTask(void* param)
+{
+	uint16_t      speed     = 100;
+	unsigned long changeAt  = millis() + 5000;
+
+	ESP32_ISR_Servos.playSequence(wave, sizeof(wave), true, speed);
+
+	while (true)
+	{
+		ESP32_ISR_Servos.updateMotion();
+
+		// Every 5s, alternate normal and double speed from the next keyframe
+		if (millis() > changeAt)
+		{
+			speed     = (speed == 100) ? 200 : 100;
+			changeAt  = millis() + 5000;
+
+			ESP32_ISR_Servos.setSequenceSpeed(speed);
+		}
+
+		// Well within the 20ms frame
+		vTaskDelay(5 / portTICK_PERIOD_MS);
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ESP32_KeyframePlayer on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_ISR_SERVO_VERSION);
+
+	//Select ESP32 timer USE_ESP32_TIMER_NO
+	ESP32_ISR_Servos.useTimer(USE_ESP32_TIMER_NO);
+
+	for (int index = 0; index < NUM_SERVOS; index++)
+		ESP32_ISR_Servos.setupServo(servoPins[index], MIN_MICROS, MAX_MICROS);
+
+	xTaskCreatePinnedToCore(motionTask, "motion", 4096, NULL, 2, NULL, 0);
+}
+
+void loop()
+{
+	// Free for the application, the keyframes play on
+	Serial.print(F("Playing = ")); Serial.println(ESP32_ISR_Servos.isPlaying());
+
+	delay(2000);
+}
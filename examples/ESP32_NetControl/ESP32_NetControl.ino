@@ -0,0 +1,122 @@
+/****************************************************************************************************************************
+   examples/ESP32_NetControl.ino
+   For ESP32 boards
+   Written by Khoi Hoang
+
+   Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+   Licensed under MIT license
+
+   Servo poses streamed from a PC over WiFi / UDP, see ESP32_ISR_ServoNet.h for the protocol. The control task is woken
+   at the start of each frame, reads all pending poses, drops the stale ones, and commits the newest into the next
+   frame. Stream with extras/host/servo_send, such as servo_send 192.168.2.50 -n 8 -r 50, to see the round trip
+*****************************************************************************************************************************/
+
+#ifndef ESP32
+	#error This code is designed to run on ESP32 platform, not Arduino nor ESP8266! Please check your Tools->Board setting.
+#endif
+
+#define TIMER_INTERRUPT_DEBUG       0
+#define ISR_SERVO_DEBUG             1
+
+// Select different ESP32 timer number (0-3) to avoid conflict
+#define USE_ESP32_TIMER_NO          3
+
+// Stop the servos when the poses stop arriving, see setFailsafe()
+#define ISR_SERVO_FAILSAFE          true
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_ISR_Servo.h"
+#include "ESP32_ISR_ServoNet.h"
+
+// Published values for SG90 servos; adjust if needed
+#define MIN_MICROS      800  //544
+#define MAX_MICROS      2450
+
+#define NUM_SERVOS      8
+
+// No pose for that long => no more pulses, until the next pose
+#define FAILSAFE_MS     500
+
+const char* ssid = "your_ssid";
+const char* pass = "your_pass";
+
+const uint8_t servoPins[NUM_SERVOS] = { 4, 5, 18, 19, 21, 22, 23, 25 };
+
+WiFiUDP             udp;
+ESP32_ISR_ServoNet  net(ESP32_ISR_Servos);
+
+// Wakes once per frame, aligned to its start
+void controlTask(void* param)
+{
+	ESP32_ISR_Servos.setFrameNotify();
+
+	while (true)
+	{
+		ESP32_ISR_Servos.waitFrame();
+
+		net.poll(udp);
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ESP32_NetControl on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_ISR_SERVO_VERSION);
+
+	//Select ESP32 timer USE_ESP32_TIMER_NO
+	ESP32_ISR_Servos.useTimer(USE_ESP32_TIMER_NO);
+
+	// servoIndex 0 to NUM_SERVOS - 1, the bits of the pose mask
+	for (int index = 0; index < NUM_SERVOS; index++)
+	{
+		int8_t servoIndex = ESP32_ISR_Servos.setupServo(servoPins[index], MIN_MICROS, MAX_MICROS, ISR_SERVO_BACKEND_ISR);
+
+		if (servoIndex == -1)
+			Serial.println(F("Setup Servo failed"));
+		else
+			ESP32_ISR_Servos.setFailsafe(servoIndex, FAILSAFE_MS, ISR_SERVO_FAILSAFE_STOP);
+	}
+
+	WiFi.mode(WIFI_STA);
+	// No WiFi power save, which would add up to 100ms of latency to each packet
+	WiFi.setSleep(false);
+	WiFi.begin(ssid, pass);
+
+	while (WiFi.status() != WL_CONNECTED)
+		delay(500);
+
+	udp.begin(ISR_SERVO_NET_PORT);
+
+	Serial.print(F("Listening on ")); Serial.print(WiFi.localIP());
+	Serial.print(F(":")); Serial.println(ISR_SERVO_NET_PORT);
+
+	// Higher priority than loop(), woken right at the end of the ISR
+	xTaskCreatePinnedToCore(controlTask, "control", 4096, NULL, 5, NULL, 1);
+}
+
+void loop()
+{
+	isr_servo_net_stats_t stats;
+
+	net.getStats(stats);
+
+	Serial.print(F("Received = ")); Serial.print(stats.received);
+	Serial.print(F(", applied = ")); Serial.print(stats.applied);
+	Serial.print(F(", stale = ")); Serial.print(stats.stale);
+	Serial.print(F(", invalid = ")); Serial.print(stats.invalid);
+	Serial.print(F(", rejected = ")); Serial.print(stats.rejected);
+	Serial.print(F(", commits = ")); Serial.print(stats.commits);
+	Serial.print(F(", failsafe = ")); Serial.println(ESP32_ISR_Servos.isFailsafe(0) ? F("on") : F("off"));
+
+	delay(2000);
+}
@@ -0,0 +1,86 @@
+/****************************************************************************************************************************
+   examples/ESP32_SmoothMotion.ino
+   For ESP32 boards
+   Written by Khoi Hoang
+
+   Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+   Licensed under MIT license
+
+   Smooth moves with moveTo(): the engine steps each servo once per 20ms frame along a linear, trapezoidal
+   or S-curve profile, within the speed / acceleration limits of setMotionLimits().
+   loop() only has to call updateMotion() more often than every 20ms, and never blocks in delay()
+*****************************************************************************************************************************/
+
+#ifndef ESP32
+	#error This code is designed to run on ESP32 platform, not Arduino nor ESP8266! Please check your Tools->Board setting.
+#endif
+
+#define TIMER_INTERRUPT_DEBUG       0
+#define ISR_SERVO_DEBUG             1
+
+// Select different ESP32 timer number (0-3) to avoid conflict
+#define USE_ESP32_TIMER_NO          3
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_ISR_Servo.h"
+
+// Published values for SG90 servos; adjust if needed
+#define MIN_MICROS      800  //544
+#define MAX_MICROS      2450
+
+#define NUM_SERVOS      3
+
+uint8_t servoPins[NUM_SERVOS]   = { 4, 5, 18 };
+int     servoIndex[NUM_SERVOS];
+
+// Each servo along a different profile
+isr_servo_profile_t profiles[NUM_SERVOS] =
+{
+	ISR_SERVO_PROFILE_LINEAR, ISR_SERVO_PROFILE_TRAPEZOIDAL, ISR_SERVO_PROFILE_SCURVE
+};
+
+uint16_t target = 180;
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ESP32_SmoothMotion on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_ISR_SERVO_VERSION);
+
+	//Select ESP32 timer USE_ESP32_TIMER_NO
+	ESP32_ISR_Servos.useTimer(USE_ESP32_TIMER_NO);
+
+	for (int index = 0; index < NUM_SERVOS; index++)
+	{
+		servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], MIN_MICROS, MAX_MICROS);
+
+		// At most 120 degrees / sec and 300 degrees / sec^2
+		ESP32_ISR_Servos.setMotionLimits(servoIndex[index], 120, 300);
+	}
+}
+
+void loop()
+{
+	// Steps all moves at most once per frame, returns false once all servos reached their target
+	if (!ESP32_ISR_Servos.updateMotion())
+	{
+		Serial.print(F("Moving to ")); Serial.println(target);
+
+		for (int index = 0; index < NUM_SERVOS; index++)
+		{
+			// 1s, stretched by the limits if needed
+			ESP32_ISR_Servos.moveTo(servoIndex[index], target, 1000, profiles[index]);
+		}
+
+		target = 180 - target;
+	}
+
+	// Any other work here, as long as loop() runs more often than every 20ms
+	delay(1);
+}
@@ -0,0 +1,127 @@
+/****************************************************************************************************************************
+   examples/ServoStats.ino
+   For ESP32 boards
+   Written by Khoi Hoang
+
+   Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+   Licensed under MIT license
+
+   Print the ISR counters of getStats() every 5s, while all servos keep moving: ISR runs, CPU cycles per run
+   (min / avg / max), ISR CPU load, longest latency from the timer alarm and late runs. With USE_WIFI, the same
+   under Wi-Fi traffic, to size how many servos a board can drive with Wi-Fi active
+*****************************************************************************************************************************/
+
+#ifndef ESP32
+	#error This code is designed to run on ESP32 platform, not Arduino nor ESP8266! Please check your Tools->Board setting.
+#endif
+
+#define TIMER_INTERRUPT_DEBUG       0
+#define ISR_SERVO_DEBUG             0
+
+// Select different ESP32 timer number (0-3) to avoid conflict
+#define USE_ESP32_TIMER_NO          3
+
+// ISR runs starting more than 2uS after their alarm are counted as late
+#define ISR_SERVO_LATE_US           2
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_ISR_Servo.h"
+
+// true => connect to Wi-Fi and keep it busy with a ping-pong of UDP packets to the gateway
+#define USE_WIFI        false
+
+#if USE_WIFI
+	#include <WiFi.h>
+	#include <WiFiUdp.h>
+
+	const char* ssid      = "your_ssid";
+	const char* password  = "your_password";
+
+	WiFiUDP udp;
+#endif
+
+// Published values for SG90 servos; adjust if needed
+#define MIN_MICROS      800  //544
+#define MAX_MICROS      2450
+
+#define NUM_SERVOS      8
+
+uint8_t servoPins[NUM_SERVOS] = { 4, 5, 12, 13, 14, 15, 18, 19 };
+int     servoIndex[NUM_SERVOS];
+
+unsigned long statsAt;
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ServoStats on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_ISR_SERVO_VERSION);
+
+#if USE_WIFI
+	WiFi.begin(ssid, password);
+
+	while (WiFi.status() != WL_CONNECTED)
+		delay(500);
+
+	Serial.print(F("WiFi connected, IP = ")); Serial.println(WiFi.localIP());
+	udp.begin(5000);
+#endif
+
+	//Select ESP32 timer USE_ESP32_TIMER_NO
+	ESP32_ISR_Servos.useTimer(USE_ESP32_TIMER_NO);
+
+	for (int index = 0; index < NUM_SERVOS; index++)
+		servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], MIN_MICROS, MAX_MICROS);
+
+	ESP32_ISR_Servos.resetStats();
+	statsAt = micros();
+}
+
+void printStats()
+{
+	isr_servo_stats_t stats;
+	unsigned long     now     = micros();
+	uint32_t          cpuMHz  = getCpuFrequencyMhz();
+
+	ESP32_ISR_Servos.getStats(stats);
+	ESP32_ISR_Servos.resetStats();
+
+	float load = 100.0f * stats.isrCyclesTotal / ( (float) cpuMHz * (now - statsAt) );
+
+	statsAt = now;
+
+	Serial.printf("ISR runs %u, frames %u, cycles min/avg/max %u/%u/%u, load %.2f%%\n", stats.isrCalls, stats.frames,
+	              stats.isrCyclesMin, stats.isrCyclesAvg, stats.isrCyclesMax, load);
+	Serial.printf("Latency max %u nS, late runs %u, missed ticks %u\n", stats.latencyMaxNs, stats.lateRuns,
+	              stats.missedTicks);
+}
+
+void loop()
+{
+	static unsigned long printAt = 5000;
+
+	// Every servo sweeping, its pulse width changing every frame
+	for (int index = 0; index < NUM_SERVOS; index++)
+		ESP32_ISR_Servos.setPosition(servoIndex[index], (millis() / 20 + index * 20) % 180);
+
+#if USE_WIFI
+	udp.beginPacket(WiFi.gatewayIP(), 5000);
+	udp.print(millis());
+	udp.endPacket();
+#endif
+
+	if (millis() > printAt)
+	{
+		printAt = millis() + 5000;
+
+		printStats();
+	}
+
+	delay(10);
+}
@@ -0,0 +1,133 @@
+/****************************************************************************************************************************
+   examples/ServoTrace.ino
+   For ESP32 boards
+   Written by Khoi Hoang
+
+   Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+   Licensed under MIT license
+
+   Capture the pulse edges applied by the ISR with ISR_SERVO_TRACE, and print them over Serial as a trace CSV:
+     time_ns,pin,level               one line per pin edge
+     #expect,pin,width_ns            programmed pulse width of pin
+     #isr_max_ns,ns                  longest ISR run
+     #dropped,entries                trace entries lost, Serial too slow
+
+   Save the Serial output to a file, then analyze it on the host with extras/host:
+     ./servo_trace analyze capture.csv -o capture
+   to get the pulse width error, frame period jitter and max ISR duration per servo (capture_report.csv),
+   and the pulse trains for GTKWave / PulseView (capture.vcd)
+*****************************************************************************************************************************/
+
+#ifndef ESP32
+	#error This code is designed to run on ESP32 platform, not Arduino nor ESP8266! Please check your Tools->Board setting.
+#endif
+
+#define TIMER_INTERRUPT_DEBUG       0
+#define ISR_SERVO_DEBUG             0
+
+// Log every edge applied by the ISR into a ring buffer
+#define ISR_SERVO_TRACE             true
+#define ISR_SERVO_TRACE_SIZE        256
+
+// Select different ESP32 timer number (0-3) to avoid conflict
+#define USE_ESP32_TIMER_NO          3
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32_ISR_Servo.h"
+
+// Published values for SG90 servos; adjust if needed
+#define MIN_MICROS      800  //544
+#define MAX_MICROS      2450
+
+#define NUM_SERVOS      4
+
+// Number of frames to capture, 20ms each
+#define TRACE_FRAMES    500
+
+uint8_t servoPins[NUM_SERVOS] = { 4, 5, 18, 19 };
+
+uint64_t  traceNs     = 0;
+uint32_t  lastCycles  = 0;
+uint32_t  cpuMHz;
+uint32_t  startMs;
+
+isr_servo_trace_t entries[32];
+
+void printEdges(const isr_servo_trace_t& entry)
+{
+	// CPU cycle count is 32-bit, wrapping every few seconds: accumulate the differences
+	traceNs    += (uint64_t) (entry.cycles - lastCycles) * 1000 / cpuMHz;
+	lastCycles  = entry.cycles;
+
+	for (int bank = 0; bank < ISR_SERVO_GPIO_BANKS; bank++)
+	{
+		for (int bit = 0; bit < 32; bit++)
+		{
+			if ( (entry.setMask[bank] | entry.clearMask[bank]) & (1UL << bit) )
+			{
+				Serial.printf("%llu,%d,%d\n", traceNs, 32 * bank + bit, (entry.setMask[bank] & (1UL << bit)) ? 1 : 0);
+			}
+		}
+	}
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\n# Starting ServoTrace on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.print(F("# "));
+	Serial.println(ESP32_ISR_SERVO_VERSION);
+
+	cpuMHz = getCpuFrequencyMhz();
+
+	//Select ESP32 timer USE_ESP32_TIMER_NO
+	ESP32_ISR_Servos.useTimer(USE_ESP32_TIMER_NO);
+
+	for (int index = 0; index < NUM_SERVOS; index++)
+	{
+		int servoIndex = ESP32_ISR_Servos.setupServo(servoPins[index], MIN_MICROS, MAX_MICROS);
+
+		// Spread positions, fixed during the capture
+		ESP32_ISR_Servos.setPosition(servoIndex, index * 180 / NUM_SERVOS);
+
+		Serial.printf("#expect,%d,%u\n", servoPins[index], ESP32_ISR_Servos.getPulseWidthNs(servoIndex));
+	}
+
+	// Let the new positions reach the ISR, then start clean
+	delay(100);
+
+	while (ESP32_ISR_Servos.readTrace(entries, 32) > 0);
+
+	ESP32_ISR_Servos.getTraceDropped();
+	ESP32_ISR_Servos.getTraceMaxIsrCycles();
+
+	lastCycles  = cpu_hal_get_cycle_count();
+	startMs     = millis();
+}
+
+void loop()
+{
+	static bool done = false;
+
+	if (done)
+		return;
+
+	uint16_t count = ESP32_ISR_Servos.readTrace(entries, 32);
+
+	for (uint16_t index = 0; index < count; index++)
+		printEdges(entries[index]);
+
+	if (millis() - startMs >= TRACE_FRAMES * (REFRESH_INTERVAL / 1000))
+	{
+		Serial.printf("#isr_max_ns,%llu\n", (uint64_t) ESP32_ISR_Servos.getTraceMaxIsrCycles() * 1000 / cpuMHz);
+		Serial.printf("#dropped,%u\n", ESP32_ISR_Servos.getTraceDropped());
+
+		done = true;
+	}
+}
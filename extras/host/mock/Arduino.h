@@ -0,0 +1,80 @@
+/****************************************************************************************************************************
+  extras/host/mock/Arduino.h
+  Host mock of the Arduino-ESP32 core, just enough for the ESP32_ISR_Servo headers
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+ *****************************************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define OUTPUT        0x03
+#define HIGH          1
+#define LOW           0
+
+class __FlashStringHelper;
+#define F(s)          (reinterpret_cast<const __FlashStringHelper *>(s))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+uint32_t getCpuFrequencyMhz();
+
+// Serial to stdout, for the ISR_SERVO_LOG* macros
+struct HostSerial
+{
+  template<typename T> void print(const T& value)
+  {
+    fputs(toString(value).c_str(), stdout);
+  }
+
+  template<typename T> void println(const T& value)
+  {
+    print(value);
+    fputs("\n", stdout);
+  }
+
+  void println()
+  {
+    fputs("\n", stdout);
+  }
+
+  void flush()
+  {
+    fflush(stdout);
+  }
+
+  static std::string toString(const char* value)
+  {
+    return value;
+  }
+
+  static std::string toString(char* value)
+  {
+    return value;
+  }
+
+  static std::string toString(const __FlashStringHelper* value)
+  {
+    return (const char*) value;
+  }
+
+  template<typename T> static std::string toString(const T& value)
+  {
+    return std::to_string(value);
+  }
+};
+
+extern HostSerial Serial;
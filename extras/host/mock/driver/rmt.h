@@ -0,0 +1,54 @@
+// Host mock of ESP-IDF v4.4 driver/rmt.h (legacy driver), implemented by the simulated RMT of sim.cpp
+#pragma once
+
+#include <stdint.h>
+#include "driver/timer.h"
+
+typedef int gpio_num_t;
+
+typedef enum { RMT_MODE_TX = 0 } rmt_mode_t;
+typedef enum { RMT_CHANNEL_0 = 0 } rmt_channel_t;
+typedef enum { RMT_IDLE_LEVEL_LOW = 0 } rmt_idle_level_t;
+
+typedef struct
+{
+  uint32_t          carrier_freq_hz;
+  int               carrier_level;
+  rmt_idle_level_t  idle_level;
+  uint8_t           carrier_duty_percent;
+  bool              carrier_en;
+  bool              loop_en;
+  bool              idle_output_en;
+} rmt_tx_config_t;
+
+typedef struct
+{
+  rmt_mode_t        rmt_mode;
+  rmt_channel_t     channel;
+  gpio_num_t        gpio_num;
+  uint8_t           clk_div;
+  uint8_t           mem_block_num;
+  uint32_t          flags;
+  rmt_tx_config_t   tx_config;
+} rmt_config_t;
+
+typedef struct
+{
+  union
+  {
+    struct
+    {
+      uint32_t duration0 : 15;
+      uint32_t level0    : 1;
+      uint32_t duration1 : 15;
+      uint32_t level1    : 1;
+    };
+
+    uint32_t val;
+  };
+} rmt_item32_t;
+
+esp_err_t rmt_config(const rmt_config_t* rmt_param);
+esp_err_t rmt_fill_tx_items(rmt_channel_t channel, const rmt_item32_t* item, uint16_t item_num, uint16_t mem_offset);
+esp_err_t rmt_tx_start(rmt_channel_t channel, bool tx_idx_rst);
+esp_err_t rmt_tx_stop(rmt_channel_t channel);
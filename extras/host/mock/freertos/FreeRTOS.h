@@ -0,0 +1,14 @@
+// Host mock of ESP-IDF v4.4 freertos/FreeRTOS.h, just the types used by ESP32_ISR_Servo
+#pragma once
+
+#include <stdint.h>
+
+typedef int           BaseType_t;
+typedef unsigned int  UBaseType_t;
+typedef uint32_t      TickType_t;
+
+#define pdFALSE             ( (BaseType_t) 0 )
+#define pdTRUE              ( (BaseType_t) 1 )
+
+#define portMAX_DELAY       ( (TickType_t) 0xffffffffUL )
+#define portTICK_PERIOD_MS  ( (TickType_t) 1 )
@@ -0,0 +1,11 @@
+// Host mock of ESP-IDF v4.4 freertos/task.h task notifications, implemented by sim.cpp with a single host task.
+// ulTaskNotifyTake() runs the simulation until notified or timed out
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct tskTaskControlBlock* TaskHandle_t;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
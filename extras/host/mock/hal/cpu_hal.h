@@ -0,0 +1,6 @@
+// Host mock of ESP-IDF v4.4 hal/cpu_hal.h, CPU cycle counter of sim.cpp
+#pragma once
+
+#include <stdint.h>
+
+uint32_t cpu_hal_get_cycle_count(void);
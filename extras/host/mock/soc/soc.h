@@ -0,0 +1,8 @@
+// Host mock of ESP-IDF soc/soc.h: register writes go to the simulated GPIO
+#pragma once
+
+#include <stdint.h>
+
+void simRegWrite(uint32_t reg, uint32_t value);
+
+#define REG_WRITE(_r, _v)     simRegWrite((uint32_t) (_r), (uint32_t) (_v))
@@ -0,0 +1,7 @@
+// Host mock of ESP-IDF soc/soc_caps.h, ESP32 values
+#pragma once
+
+#define SOC_GPIO_PIN_COUNT                40
+#define SOC_LEDC_CHANNEL_NUM              8
+#define SOC_LEDC_TIMER_BIT_WIDE_NUM       20
+#define SOC_RMT_TX_CANDIDATES_PER_GROUP   8
@@ -0,0 +1,91 @@
+/****************************************************************************************************************************
+  extras/host/servo_bench.cpp
+  Host benchmark of ESP32_ISR_Servo::run() against the simulated ESP32 peripherals of sim.cpp
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Usage: servo_bench [number of servos] [number of frames]
+  Reports host time per ISR call, and simulated ISR calls and cycles per frame. Run it under perf to profile run()
+ *****************************************************************************************************************************/
+
+#include "ESP32_ISR_Servo.h"
+
+#include "sim.h"
+
+#include <stdlib.h>
+#include <chrono>
+
+int main(int argc, char* argv[])
+{
+  int numServos = (argc > 1) ? atoi(argv[1]) : ESP32_ISR_Servo::MAX_SERVOS;
+  int numFrames = (argc > 2) ? atoi(argv[2]) : 10000;
+
+  // Any pin of both GPIO banks, except the flash pins
+  static const uint8_t pins[] = { 2, 4, 5, 12, 13, 14, 15, 16, 17, 18, 19, 21, 22, 23, 25, 26, 27, 32, 33 };
+
+  for (int index = 0; (index < numServos) && (index < (int) sizeof(pins)); index++)
+  {
+    int8_t servoIndex = ESP32_ISR_Servos.setupServo(pins[index], MIN_PULSE_WIDTH, MAX_PULSE_WIDTH, ISR_SERVO_BACKEND_ISR);
+
+    ESP32_ISR_Servos.setPosition(servoIndex, (index * 37) % 180);
+  }
+
+  sim::recordEdges = false;
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+
+  auto start = std::chrono::steady_clock::now();
+
+  sim::runUntil(sim::now + sim::us((double) numFrames * REFRESH_INTERVAL));
+
+  auto   end    = std::chrono::steady_clock::now();
+  double hostNs = std::chrono::duration<double, std::nano>(end - start).count();
+
+  // Setter cost, rebuilding the frame from the active servos only
+  const int numUpdates = 100000;
+
+  start = std::chrono::steady_clock::now();
+
+  for (int update = 0; update < numUpdates; update++)
+    ESP32_ISR_Servos.setPosition(update % ESP32_ISR_Servos.getNumServos(), update % 180);
+
+  end = std::chrono::steady_clock::now();
+
+  double updateNs = std::chrono::duration<double, std::nano>(end - start).count() / numUpdates;
+
+  // Full pose in one call, against one setPosition() per servo
+  uint16_t  pose[32];
+  uint32_t  mask      = (ESP32_ISR_Servos.getNumServos() >= 32) ? 0xFFFFFFFFUL : (1UL << ESP32_ISR_Servos.getNumServos()) - 1;
+  const int numPoses  = numUpdates / ESP32_ISR_Servos.getNumServos();
+
+  start = std::chrono::steady_clock::now();
+
+  for (int update = 0; update < numPoses; update++)
+  {
+    for (int index = 0; index < ESP32_ISR_Servos.getNumServos(); index++)
+      pose[index] = (update + index) % 180;
+
+    ESP32_ISR_Servos.setPositions(pose, mask);
+  }
+
+  end = std::chrono::steady_clock::now();
+
+  double poseNs = std::chrono::duration<double, std::nano>(end - start).count() / numPoses;
+
+  printf("%s, %s, %d servos, %d frames\n", ESP32_ISR_SERVO_VERSION,
+         ISR_SERVO_USING_EDGE_SCHEDULING ? "edge scheduling" : "tick", ESP32_ISR_Servos.getNumServos(), numFrames);
+  printf("ISR calls per frame       : %.1f\n", (double) sim::isrCalls / numFrames);
+  printf("GPIO writes per frame     : %.1f\n", (double) sim::regWrites / numFrames);
+  printf("ISR cycles per frame      : %.1f (counter reads and busy-waits)\n", (double) sim::isrCycles / numFrames);
+  printf("Max ISR cycles            : %llu\n", (unsigned long long) sim::isrCyclesMax);
+  printf("Host ns per ISR call      : %.1f\n", hostNs / sim::isrCalls);
+  printf("Host ns per setPosition() : %.1f\n", updateNs);
+  printf("Host ns per setPositions(): %.1f, %d servos (%.1f with setPosition())\n", poseNs,
+         ESP32_ISR_Servos.getNumServos(), updateNs * ESP32_ISR_Servos.getNumServos());
+  printf("Engine RAM, 16 / 4 servos : %u / %u bytes\n", (unsigned) sizeof(ESP32_ISR_Servo),
+         (unsigned) sizeof(ESP32_ISR_ServoT<4>));
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+/****************************************************************************************************************************
+  extras/host/servo_send.cpp
+  Host sender of the ESP32_ISR_ServoNet pose protocol: streams a sweep of all servos and measures the round trip
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Usage: servo_send address [-p port] [-n servos] [-r poses per sec] [-c poses] [-a ack every n poses]
+    Sends poses of servos 0 to n - 1, pulse widths sweeping 1000 - 2000uS, to an ESP32 running
+    examples/ESP32_NetControl. Acked poses report the round trip min / avg / max, and the pose status counts
+ *****************************************************************************************************************************/
+
+#include "ESP32_ISR_Servo.h"
+#include "ESP32_ISR_ServoNet.h"
+
+#include "udp.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static uint32_t nowUs()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void usage()
+{
+  fprintf(stderr, "servo_send address [-p port] [-n servos] [-r poses per sec] [-c poses] [-a ack every n poses]\n");
+  exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+    usage();
+
+  uint32_t  address   = inet_addr(argv[1]);
+  uint16_t  port      = ISR_SERVO_NET_PORT;
+  int       numServos = 16;
+  int       rate      = 50;
+  int       numPoses  = 500;
+  int       ackEvery  = 1;
+
+  for (int arg = 2; arg + 1 < argc; arg += 2)
+  {
+    std::string option = argv[arg];
+
+    if (option == "-p")
+      port = atoi(argv[arg + 1]);
+    else if (option == "-n")
+      numServos = std::min(std::max(atoi(argv[arg + 1]), 1), 32);
+    else if (option == "-r")
+      rate = std::max(atoi(argv[arg + 1]), 1);
+    else if (option == "-c")
+      numPoses = atoi(argv[arg + 1]);
+    else if (option == "-a")
+      ackEvery = atoi(argv[arg + 1]);
+    else
+      usage();
+  }
+
+  HostUDP udp;
+
+  if ( (address == INADDR_NONE) || !udp.begin(0) )
+    usage();
+
+  uint8_t   packet[ISR_SERVO_NET_MAX_PACKET];
+  uint16_t  widths[32];
+  uint32_t  mask      = (numServos == 32) ? 0xFFFFFFFFUL : (1UL << numServos) - 1;
+  uint32_t  acks      = 0;
+  uint32_t  statuses[4] = { 0 };
+  uint32_t  rttMin    = UINT32_MAX;
+  uint32_t  rttMax    = 0;
+  uint64_t  rttTotal  = 0;
+
+  auto receive = [&]()
+  {
+    int length;
+
+    while ( (length = udp.parsePacket()) > 0 )
+    {
+      uint32_t                seq;
+      uint32_t                timeUs;
+      isr_servo_net_status_t  status;
+
+      length = udp.read(packet, sizeof(packet));
+
+      if ( !ESP32_ISR_ServoNet::decodeAck(packet, length, seq, timeUs, status) || (status > ISR_SERVO_NET_REJECTED) )
+        continue;
+
+      uint32_t rtt = nowUs() - timeUs;
+
+      acks++;
+      statuses[status]++;
+      rttMin    = std::min(rttMin, rtt);
+      rttMax    = std::max(rttMax, rtt);
+      rttTotal += rtt;
+    }
+  };
+
+  auto next = std::chrono::steady_clock::now();
+
+  for (int pose = 0; pose < numPoses; pose++)
+  {
+    for (int index = 0; index < numServos; index++)
+      widths[index] = 1500 + 500 * sin(2 * M_PI * (pose + index * 10) / 100.0);
+
+    uint8_t flags = ( (ackEvery > 0) && (pose % ackEvery == 0) ) ? ISR_SERVO_NET_FLAG_ACK : 0;
+
+    udp.beginPacket(address, port);
+    udp.write(packet, ESP32_ISR_ServoNet::encodePose(packet, pose + 1, nowUs(), mask, widths, flags));
+    udp.endPacket();
+
+    next += std::chrono::microseconds(1000000 / rate);
+
+    while (std::chrono::steady_clock::now() < next)
+    {
+      receive();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  // Late acks
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  receive();
+
+  int acked = (ackEvery > 0) ? (numPoses + ackEvery - 1) / ackEvery : 0;
+
+  printf("Poses %d, acked %u / %d, applied %u, stale %u, invalid %u, rejected %u\n", numPoses, acks, acked,
+         statuses[ISR_SERVO_NET_APPLIED], statuses[ISR_SERVO_NET_STALE], statuses[ISR_SERVO_NET_INVALID],
+         statuses[ISR_SERVO_NET_REJECTED]);
+
+  if (acks > 0)
+    printf("Round trip uS min / avg / max : %u / %u / %u\n", rttMin, (uint32_t) (rttTotal / acks), rttMax);
+
+  return (acks < (uint32_t) acked) ? 1 : 0;
+}
@@ -0,0 +1,1758 @@
+/****************************************************************************************************************************
+  extras/host/servo_sim.cpp
+  Runs ESP32_ISR_Servo against the simulated ESP32 peripherals of sim.cpp and checks the recorded pulse trains
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Usage: servo_sim [ISR latency in APB cycles]
+  Exit code is the number of failed checks
+ *****************************************************************************************************************************/
+
+#include "ESP32_ISR_Servo.h"
+#include "ESP32_ISR_ServoNet.h"
+
+#include "sim.h"
+#include "udp.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
+#define NUM_SERVOS      6
+
+static const uint8_t servoPins[NUM_SERVOS] = { 3, 4, 5, 18, 19, 33 };
+
+static int failures = 0;
+
+static void check(const bool& ok, const char* what)
+{
+  printf("%s %s\n", ok ? "[PASS]" : "[FAIL]", what);
+
+  if (!ok)
+    failures++;
+}
+
+typedef struct
+{
+  int     pulses;
+  double  widthMin;
+  double  widthMax;
+  double  periodMin;
+  double  periodMax;
+} pulse_stats_t;
+
+// Widths and periods of the complete pulses of pin in the recorded edges, in microsecs
+static pulse_stats_t measure(const uint8_t& pin)
+{
+  pulse_stats_t stats = { 0, 1e9, 0, 1e9, 0 };
+  bool          risen = false;
+  uint64_t      riseAt = 0;
+
+  for (auto& edge : sim::edges)
+  {
+    if (edge.pin != pin)
+      continue;
+
+    if (edge.level)
+    {
+      if (risen)
+      {
+        stats.periodMin = fmin(stats.periodMin, sim::toUs(edge.t - riseAt));
+        stats.periodMax = fmax(stats.periodMax, sim::toUs(edge.t - riseAt));
+      }
+
+      risen   = true;
+      riseAt  = edge.t;
+    }
+    else if (risen)
+    {
+      stats.pulses++;
+      stats.widthMin = fmin(stats.widthMin, sim::toUs(edge.t - riseAt));
+      stats.widthMax = fmax(stats.widthMax, sim::toUs(edge.t - riseAt));
+    }
+  }
+
+  return stats;
+}
+
+// Frame period of the ISR engine: REFRESH_INTERVAL rounded down to TIMER_INTERVAL_MICRO in tick mode
+#define ISR_PERIOD_US     ISR_SERVO_COUNT_TO_US(ISR_SERVO_US_TO_COUNT(REFRESH_INTERVAL))
+
+static bool checkPulses(const uint8_t& pin, const double& widthUs, const double& tolerance,
+                        const double& periodUs = ISR_PERIOD_US)
+{
+  pulse_stats_t stats = measure(pin);
+
+  printf("  pin %2d: %d pulses, width %.2f..%.2f uS (expected %.2f), period %.2f..%.2f uS\n", pin, stats.pulses,
+         stats.widthMin, stats.widthMax, widthUs, stats.periodMin, stats.periodMax);
+
+  return (stats.pulses > 0) && (fabs(stats.widthMin - widthUs) <= tolerance) && (fabs(stats.widthMax - widthUs) <= tolerance)
+         && (fabs(stats.periodMin - periodUs) <= tolerance) && (fabs(stats.periodMax - periodUs) <= tolerance);
+}
+
+// Width of each complete pulse of pin in the recorded edges, in microsecs
+static std::vector<double> pulseWidths(const uint8_t& pin)
+{
+  std::vector<double> widths;
+  uint64_t            riseAt = 0;
+  bool                risen  = false;
+
+  for (auto& edge : sim::edges)
+  {
+    if (edge.pin != pin)
+      continue;
+
+    if (edge.level)
+    {
+      risen   = true;
+      riseAt  = edge.t;
+    }
+    else if (risen)
+      widths.push_back(sim::toUs(edge.t - riseAt));
+  }
+
+  return widths;
+}
+
+static void deleteAll(int8_t* servoIndex, const int& count)
+{
+  for (int index = 0; index < count; index++)
+  {
+    if (servoIndex[index] >= 0)
+      ESP32_ISR_Servos.deleteServo(servoIndex[index]);
+  }
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+}
+
+// Fixed positions: every pulse has the programmed width, and every period is exactly the frame period
+static void staticPositions()
+{
+  int8_t servoIndex[NUM_SERVOS];
+
+  printf("\nStatic positions\n");
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], index * 30);
+  }
+
+  uint32_t widthNs = 1234567;
+  ESP32_ISR_Servos.setPulseWidthNs(servoIndex[NUM_SERVOS - 1], widthNs);
+
+  sim::runUntil(sim::now + sim::us(5 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  bool ok = true;
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+    ok &= checkPulses(servoPins[index], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[index]) / 1000.0, 0.2);
+
+  check(ok, "pulse widths and periods");
+
+#if ISR_SERVO_USING_EDGE_SCHEDULING
+  printf("  %llu ISR calls in 10 frames\n", (unsigned long long) sim::isrCalls);
+  check(sim::isrCalls <= 10 * (NUM_SERVOS + 1), "at most (numServos + 1) ISR calls per frame");
+#endif
+
+  deleteAll(servoIndex, NUM_SERVOS);
+}
+
+// Random updates at random times: every pulse must be one of the widths set, never a mix of two frames
+static void randomUpdates()
+{
+  int8_t                          servoIndex[NUM_SERVOS];
+  std::map<int, std::set<long>>   allowed;
+
+  printf("\nRandom updates\n");
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    allowed[servoPins[index]].insert(ESP32_ISR_Servos.getPulseWidth(servoIndex[index]));
+  }
+
+  sim::clear();
+  srand(1);
+
+  for (int update = 0; update < 3000; update++)
+  {
+    sim::runUntil(sim::now + sim::us(rand() % 3000));
+
+    int      index      = rand() % NUM_SERVOS;
+    uint16_t pulseWidth = 800 + rand() % 1650;
+
+    ESP32_ISR_Servos.setPulseWidth(servoIndex[index], pulseWidth);
+    allowed[servoPins[index]].insert(ESP32_ISR_Servos.getPulseWidth(servoIndex[index]));
+  }
+
+  ESP32_ISR_Servos.deleteServo(servoIndex[0]);
+  servoIndex[0] = -1;
+
+  sim::runUntil(sim::now + sim::us(5 * REFRESH_INTERVAL));
+
+  std::map<int, uint64_t> riseAt;
+  int                     pulses = 0;
+  int                     bad    = 0;
+
+  // ISR latency delays edges unevenly, such as those bunched within the edge guard time, up to the latency itself
+  const long tolerance = lround(sim::toUs(sim::isrLatency) + ISR_SERVO_COUNT_TO_NS(1) / 1000.0);
+
+  for (auto& edge : sim::edges)
+  {
+    if (edge.level)
+      riseAt[edge.pin] = edge.t;
+    else if (riseAt.count(edge.pin))
+    {
+      long width = lround(sim::toUs(edge.t - riseAt[edge.pin]));
+
+      pulses++;
+
+      // Any width set within the tolerance
+      auto set = allowed[edge.pin].lower_bound(width - tolerance);
+
+      if ( (set == allowed[edge.pin].end()) || (*set > width + tolerance) )
+        bad++;
+    }
+  }
+
+  printf("  %d pulses, %d with a width never set\n", pulses, bad);
+  check(bad == 0, "no torn pulses");
+  check(sim::level(servoPins[0]) == LOW, "deleted servo left LOW");
+
+  deleteAll(servoIndex, NUM_SERVOS);
+}
+
+// Staggered rising edges: same widths and periods, fewer outputs HIGH at the same time
+static void staggered()
+{
+  int8_t servoIndex[NUM_SERVOS];
+
+  printf("\nStaggered pulses\n");
+
+  ESP32_ISR_Servos.setStaggered(true);
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 180);
+  }
+
+  sim::runUntil(sim::now + sim::us(5 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  bool          ok      = true;
+  std::set<int> high;
+  size_t        maxHigh = 0;
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+    ok &= checkPulses(servoPins[index], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[index]) / 1000.0, 0.2);
+
+  for (auto& edge : sim::edges)
+  {
+    if (edge.level)
+      high.insert(edge.pin);
+    else
+      high.erase(edge.pin);
+
+    maxHigh = (high.size() > maxHigh) ? high.size() : maxHigh;
+  }
+
+  printf("  at most %zu outputs HIGH at the same time\n", maxHigh);
+
+  check(ok, "staggered pulse widths and periods");
+  check(maxHigh <= 3, "at most 3 outputs HIGH at the same time");
+
+  ESP32_ISR_Servos.setStaggered(false);
+
+  deleteAll(servoIndex, NUM_SERVOS);
+}
+
+// Servos on LEDC and RMT channels, next to servos on the ISR
+static void hardwareBackends()
+{
+  int8_t servoIndex[3];
+
+  printf("\nHardware backends\n");
+
+  servoIndex[0] = ESP32_ISR_Servos.setupServo(servoPins[0], 800, 2450, ISR_SERVO_BACKEND_LEDC);
+  servoIndex[1] = ESP32_ISR_Servos.setupServo(servoPins[1], 800, 2450, ISR_SERVO_BACKEND_RMT);
+  servoIndex[2] = ESP32_ISR_Servos.setupServo(servoPins[2], 800, 2450, ISR_SERVO_BACKEND_ISR);
+
+  check( (servoIndex[0] >= 0) == (ISR_SERVO_LEDC_CHANNELS > 0), "LEDC servo only with ISR_SERVO_LEDC_CHANNELS");
+  check( (servoIndex[1] >= 0) == (ISR_SERVO_RMT_CHANNELS > 0), "RMT servo only with ISR_SERVO_RMT_CHANNELS");
+
+  for (int index = 0; index < 3; index++)
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 60 * index + 30);
+
+  sim::runUntil(sim::now + sim::us(5 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  // LEDC resolution is 20mS >> ISR_SERVO_LEDC_RESOLUTION
+  if (servoIndex[0] >= 0)
+    check(checkPulses(servoPins[0], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[0]) / 1000.0,
+                      (double) REFRESH_INTERVAL / (1 << ISR_SERVO_LEDC_RESOLUTION), REFRESH_INTERVAL), "LEDC pulses");
+
+  if (servoIndex[1] >= 0)
+    check(checkPulses(servoPins[1], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[1]) / 1000.0, 0.2, REFRESH_INTERVAL),
+          "RMT pulses");
+
+  check(checkPulses(servoPins[2], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[2]) / 1000.0, 0.2), "ISR pulses");
+
+  deleteAll(servoIndex, 3);
+
+  check( (sim::level(servoPins[0]) == LOW) && (sim::level(servoPins[1]) == LOW), "deleted servos left LOW");
+}
+
+// Second engine on its own timer, next to the default one, sharing the LEDC channels
+static void twoEngines()
+{
+  static const uint8_t armPins[] = { 12, 13, 14, 15, 16, 17, 21, 22 };
+
+  const uint8_t armServos = sizeof(armPins);
+
+  ESP32_ISR_ServoT<armServos> arm(1);
+  int8_t          servoIndex[NUM_SERVOS];
+  int8_t          armIndex[armServos];
+
+  printf("\nTwo engines\n");
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], index * 30);
+  }
+
+  for (int index = 0; index < armServos; index++)
+  {
+    armIndex[index] = arm.setupServo(armPins[index], 800, 2450, (index < ISR_SERVO_LEDC_CHANNELS) ?
+                                     ISR_SERVO_BACKEND_LEDC : ISR_SERVO_BACKEND_ISR);
+    arm.setPosition(armIndex[index], 180 - index * 20);
+  }
+
+  // All LEDC channels taken by the arm engine
+  int8_t noChannel = ESP32_ISR_Servos.setupServo(2, 800, 2450, ISR_SERVO_BACKEND_LEDC);
+
+  check(noChannel < 0, "LEDC channels shared between engines");
+
+  // Timer 1 already runs the arm engine
+  ESP32_ISR_ServoT<4> clash(1);
+
+  int8_t clashIndex = clash.setupServo(2, 800, 2450, ISR_SERVO_BACKEND_ISR);
+
+  check( (clashIndex < 0) && !clash.setPosition(clashIndex, 90) && (clash.setupServo(2, 800, 2450) < 0),
+         "no second engine on a timer in use");
+
+  // Not zeroed, as on the stack or the heap: calls before the first setupServo() change nothing
+  typedef ESP32_ISR_ServoT<4> engine_t;
+
+  void* memory = malloc(sizeof(engine_t));
+
+  memset(memory, 0xA5, sizeof(engine_t));
+
+  engine_t* fresh = new (memory) engine_t(2);
+
+  fresh->enableAll();
+  fresh->disableAll();
+  fresh->enable(0);
+  fresh->disable(0);
+  fresh->toggle(1);
+  fresh->toggle(1);
+  fresh->deleteServo(2);
+
+  check( !fresh->setPosition(0, 90) && !fresh->isEnabled(1)
+         && (fresh->setupServo(2, 800, 2450, ISR_SERVO_BACKEND_ISR) == 0),
+         "setters before the first setupServo() of a fresh engine");
+
+  fresh->~engine_t();
+  free(memory);
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  bool ok = true;
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+    ok &= checkPulses(servoPins[index], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[index]) / 1000.0, 0.2);
+
+  for (int index = ISR_SERVO_LEDC_CHANNELS; index < armServos; index++)
+    ok &= checkPulses(armPins[index], arm.getPulseWidthNs(armIndex[index]) / 1000.0, 0.2);
+
+  check(ok, "pulse widths and periods of both engines");
+
+#if ISR_SERVO_USING_EDGE_SCHEDULING
+  // (numServos + 1) per frame and per engine
+  check(sim::isrCalls <= 10 * (NUM_SERVOS + 1 + armServos - ISR_SERVO_LEDC_CHANNELS + 1), "ISR calls of both engines");
+#endif
+
+  deleteAll(servoIndex, NUM_SERVOS);
+
+  // arm goes out of scope here, releasing its timer and LEDC channels
+}
+
+// Engine sized for more than 16 servos, all slots usable and no more
+static void largeEngine()
+{
+  static const uint8_t pins[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 21, 22, 23, 25 };
+
+  const uint8_t largeServos = sizeof(pins);
+
+  ESP32_ISR_ServoT<largeServos> large(2);
+  int8_t                        servoIndex[largeServos];
+
+  printf("\nEngine of %d servos\n", largeServos);
+
+  for (int index = 0; index < largeServos; index++)
+  {
+    servoIndex[index] = large.setupServo(pins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    large.setPosition(servoIndex[index], index * 180 / largeServos);
+  }
+
+  check( (large.getNumServos() == largeServos) && (large.setupServo(26, 800, 2450, ISR_SERVO_BACKEND_ISR) < 0),
+         "all slots used, no more");
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  bool ok = true;
+
+  for (int index = 0; index < largeServos; index++)
+    ok &= checkPulses(pins[index], large.getPulseWidthNs(servoIndex[index]) / 1000.0, 0.2);
+
+  check(ok, "pulse widths and periods");
+
+  // The offsets of the last slots are clamped for their max pulse width to end with the frame
+  large.setStaggered(true);
+
+  for (int index = 0; index < largeServos; index++)
+    large.setPosition(servoIndex[index], 180);
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  // Their falls just before the frame start bunch with its rises under ISR latency
+  const double tolerance = 0.2 + sim::toUs(sim::isrLatency);
+
+  ok = true;
+
+  for (int index = 0; index < largeServos; index++)
+    ok &= checkPulses(pins[index], large.getPulseWidthNs(servoIndex[index]) / 1000.0, tolerance);
+
+  check(ok, "staggered max pulse widths and periods, up to the last slot");
+}
+
+// Run a move of servoIndex, calling updateMotion() every millisecond as a sketch loop() would. returns its pulse widths
+static std::vector<double> runMove(const int8_t& servoIndex, const uint8_t& pin, const uint16_t& position,
+                                   const uint32_t& durationMs, const isr_servo_profile_t& profile)
+{
+  // At least one complete pulse at the start position
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  ESP32_ISR_Servos.moveTo(servoIndex, position, durationMs, profile);
+
+  while (ESP32_ISR_Servos.updateMotion())
+    sim::runUntil(sim::now + sim::us(1000));
+
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  return pulseWidths(pin);
+}
+
+// Pulse widths of a move: monotonic from first to last, and largest step per frame
+static bool checkMove(const std::vector<double>& widths, const double& fromUs, const double& toUs, int& moveFrames,
+                      double& firstStep, double& maxStep)
+{
+  bool ok = !widths.empty() && (fabs(widths.front() - fromUs) < 0.2) && (fabs(widths.back() - toUs) < 0.2);
+
+  moveFrames  = 0;
+  firstStep   = 0;
+  maxStep     = 0;
+
+  for (size_t index = 1; index < widths.size(); index++)
+  {
+    double step = widths[index] - widths[index - 1];
+
+    ok &= (toUs > fromUs) ? (step >= 0) : (step <= 0);
+
+    if (fabs(step) > 0)
+    {
+      if (moveFrames == 0)
+        firstStep = fabs(step);
+
+      moveFrames++;
+      maxStep = fmax(maxStep, fabs(step));
+    }
+  }
+
+  return ok;
+}
+
+// moveTo() along each profile, and within speed limits
+static void smoothMotion()
+{
+  int8_t servoIndex = ESP32_ISR_Servos.setupServo(servoPins[0], 800, 2450, ISR_SERVO_BACKEND_ISR);
+
+  const double  minUs   = ISR_SERVO_COUNT_TO_NS(ISR_SERVO_US_TO_COUNT(800)) / 1000.0;
+  const double  maxUs   = ISR_SERVO_COUNT_TO_NS(ISR_SERVO_US_TO_COUNT(2450)) / 1000.0;
+  const double  rangeUs = maxUs - minUs;
+
+  // 1s => 50 frames, steps of the linear move are rangeUs / 50
+  const int     frames  = 1000000 / REFRESH_INTERVAL;
+
+  // Pulse width resolution, steps smaller than this are merged into later ones
+  const double  stepUs  = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+
+  int     moveFrames;
+  double  firstStep, maxStep;
+  bool    ok;
+
+  printf("\nSmooth motion\n");
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+
+  ok = checkMove(runMove(servoIndex, servoPins[0], 180, 1000, ISR_SERVO_PROFILE_LINEAR), minUs, maxUs, moveFrames,
+                 firstStep, maxStep);
+  printf("  linear     : %d frames, first step %.1f uS, max step %.1f uS\n", moveFrames, firstStep, maxStep);
+  check(ok && (abs(moveFrames - frames) <= 1) && (maxStep < 1.1 * rangeUs / frames + stepUs),
+        "linear move, constant speed");
+
+  ok = checkMove(runMove(servoIndex, servoPins[0], 0, 1000, ISR_SERVO_PROFILE_TRAPEZOIDAL), maxUs, minUs, moveFrames,
+                 firstStep, maxStep);
+  printf("  trapezoidal: %d frames, first step %.1f uS, max step %.1f uS\n", moveFrames, firstStep, maxStep);
+  check(ok && (moveFrames <= frames + 1) && (maxStep < 1.1 * 4 / 3 * rangeUs / frames + stepUs)
+        && (firstStep < rangeUs / frames), "trapezoidal move, accelerating");
+
+  ok = checkMove(runMove(servoIndex, servoPins[0], 180, 1000, ISR_SERVO_PROFILE_SCURVE), minUs, maxUs, moveFrames,
+                 firstStep, maxStep);
+  printf("  S-curve    : %d frames, first step %.1f uS, max step %.1f uS\n", moveFrames, firstStep, maxStep);
+  check(ok && (moveFrames <= frames + 1) && (maxStep < 1.1 * 1.875 * rangeUs / frames + stepUs)
+        && (firstStep < 0.1 * rangeUs / frames + stepUs), "S-curve move, smooth start");
+
+  // 90 degrees / sec => 180 degrees in 2s linear, even if asked in 0.5s
+  ESP32_ISR_Servos.setMotionLimits(servoIndex, 90);
+
+  ok = checkMove(runMove(servoIndex, servoPins[0], 0, 500, ISR_SERVO_PROFILE_LINEAR), maxUs, minUs, moveFrames,
+                 firstStep, maxStep);
+  printf("  limited    : %d frames, max step %.1f uS\n", moveFrames, maxStep);
+  check(ok && (abs(moveFrames - 2 * frames) <= 1), "move stretched to max speed");
+
+  // Any setter cancels the move
+  ESP32_ISR_Servos.moveTo(servoIndex, 180, 1000);
+  ESP32_ISR_Servos.updateMotion();
+  ESP32_ISR_Servos.setPosition(servoIndex, 90);
+
+  check(!ESP32_ISR_Servos.isMoving(servoIndex) && !ESP32_ISR_Servos.updateMotion()
+        && (ESP32_ISR_Servos.getPosition(servoIndex) == 90), "setPosition() cancels the move");
+
+  ESP32_ISR_Servos.deleteServo(servoIndex);
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+}
+
+// Index of the first pulse of widths different from the first one, or -1
+static int firstChange(const std::vector<double>& widths)
+{
+  for (size_t index = 1; index < widths.size(); index++)
+  {
+    if (fabs(widths[index] - widths[0]) > 0.05)
+      return index;
+  }
+
+  return -1;
+}
+
+// Index of the first pulse at the final width, or -1
+static int arrival(const std::vector<double>& widths)
+{
+  for (size_t index = 0; index < widths.size(); index++)
+  {
+    if (fabs(widths[index] - widths.back()) <= 0.05)
+      return index;
+  }
+
+  return -1;
+}
+
+// Changes grouped by beginUpdate() / commitUpdate() switch in the same frame, even when set across several frames
+static void groupUpdates()
+{
+  int8_t servoIndex[NUM_SERVOS];
+
+  printf("\nGroup updates\n");
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 0);
+  }
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  // Slow task: 7ms between setters, the group spans 2 frames
+  ESP32_ISR_Servos.beginUpdate();
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 30 + index * 20);
+    sim::runUntil(sim::now + sim::us(7000));
+  }
+
+  int held = firstChange(pulseWidths(servoPins[0]));
+
+  ESP32_ISR_Servos.commitUpdate();
+
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  int  changeAt = firstChange(pulseWidths(servoPins[0]));
+  bool ok       = (held < 0) && (changeAt > 0);
+
+  for (int index = 1; index < NUM_SERVOS; index++)
+    ok &= (firstChange(pulseWidths(servoPins[index])) == changeAt);
+
+  check(ok, "all servos of the group switch in the same frame, after commitUpdate()");
+
+  // Joints at different distances, one slowed down by its limits, start and arrive together.
+  // Linear, so each joint steps every frame, by at least one count with edge scheduling
+  const uint8_t   joints[3]     = { (uint8_t) servoIndex[0], (uint8_t) servoIndex[2], (uint8_t) servoIndex[4] };
+  const uint16_t  positions[3]  = { 180, 0, 180 };
+
+  // 70 degrees at 35 degrees / sec => 2s, 100 frames
+  ESP32_ISR_Servos.setMotionLimits(servoIndex[4], 35);
+
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  ESP32_ISR_Servos.moveGroupTo(joints, positions, 3, 500, ISR_SERVO_PROFILE_LINEAR);
+
+  bool stopTogether = true;
+
+  while (ESP32_ISR_Servos.updateMotion())
+  {
+    sim::runUntil(sim::now + sim::us(1000));
+
+    stopTogether &= (ESP32_ISR_Servos.isMoving(joints[0]) == ESP32_ISR_Servos.isMoving(joints[1]))
+                    && (ESP32_ISR_Servos.isMoving(joints[0]) == ESP32_ISR_Servos.isMoving(joints[2]));
+  }
+
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  int start[3], end[3];
+
+  for (int index = 0; index < 3; index++)
+  {
+    std::vector<double> widths = pulseWidths(servoPins[2 * index]);
+
+    start[index]  = firstChange(widths);
+    end[index]    = arrival(widths);
+  }
+
+  printf("  start at pulse %d / %d / %d, arrival at pulse %d / %d / %d\n", start[0], start[1], start[2],
+         end[0], end[1], end[2]);
+
+  // Steps below the pulse resolution (tick mode) merge into the next frame
+  const int slack = (ISR_SERVO_COUNT_TO_NS(1) > 1000) ? 2 : 0;
+
+  check(stopTogether && (abs(start[1] - start[0]) <= slack) && (abs(start[2] - start[0]) <= slack)
+        && (end[0] == end[1]) && (end[0] == end[2]) && (abs(end[0] - start[0] + 1 - 100) <= 1 + slack),
+        "moveGroupTo() joints start and arrive together");
+
+  // Within the group of the caller, left open
+  const uint16_t  middle[3] = { 90, 90, 90 };
+
+  ESP32_ISR_Servos.beginUpdate();
+  ESP32_ISR_Servos.moveGroupTo(joints, middle, 3, 200, ISR_SERVO_PROFILE_LINEAR);
+
+  bool grouped = ESP32_ISR_Servos.isUpdating();
+
+  ESP32_ISR_Servos.commitUpdate();
+
+  check(grouped && !ESP32_ISR_Servos.isUpdating(), "moveGroupTo() joins the group of the caller");
+
+  while (ESP32_ISR_Servos.updateMotion())
+    sim::runUntil(sim::now + sim::us(1000));
+
+  deleteAll(servoIndex, NUM_SERVOS);
+}
+
+// Keyframes in flash: servo 0 to 180 in 400ms, then both servos to 0 in 600ms
+static const uint8_t keyframes[] =
+{
+  ISR_SERVO_KEYFRAME(0,     0x03),  0, 180,
+  ISR_SERVO_KEYFRAME(400,   0x01),  180,
+  ISR_SERVO_KEYFRAME(1000,  0x03),  0, 0
+};
+
+// Pulses of both servos while playing keyframes, until the end or numFrames
+static void runSequence(std::vector<double>* widths, const uint8_t& pin0, const uint8_t& pin1, const int& numFrames)
+{
+  int frames = 0;
+
+  while (ESP32_ISR_Servos.updateMotion() && (frames++ < numFrames * 20))
+    sim::runUntil(sim::now + sim::us(1000));
+
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  widths[0] = pulseWidths(pin0);
+  widths[1] = pulseWidths(pin1);
+}
+
+// Number of pulses from the first keyframe to the last one, both servos
+static bool checkSequence(const std::vector<double>* widths, const int& expectFrames, const int& slack)
+{
+  int start   = firstChange(widths[0]);
+  int end0    = arrival(widths[0]);
+  int end1    = arrival(widths[1]);
+  double top  = *std::max_element(widths[0].begin(), widths[0].end());
+  double step = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+
+  printf("  start at pulse %d / %d, arrival at pulse %d / %d, servo 0 up to %.1fuS\n", start, firstChange(widths[1]),
+         end0, end1, top);
+
+  return (start > 0) && (firstChange(widths[1]) == start) && (abs(end0 - end1) <= slack)
+         && (abs(end0 - start - expectFrames) <= 1 + slack) && (fabs(top - 2450) < step) && (fabs(widths[0].back() - 800) < step);
+}
+
+// Keyframes played by updateMotion(), at speed, and looping
+static void keyframePlayer()
+{
+  int8_t              servoIndex[2];
+  std::vector<double> widths[2];
+
+  printf("\nKeyframe player\n");
+
+  for (int index = 0; index < 2; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 90);
+  }
+
+  const int slack = (ISR_SERVO_COUNT_TO_NS(1) > 1000) ? 2 : 0;
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  check(ESP32_ISR_Servos.playSequence(keyframes, sizeof(keyframes)), "playSequence()");
+  runSequence(widths, servoPins[0], servoPins[1], 1000);
+
+  check(checkSequence(widths, 50, slack) && !ESP32_ISR_Servos.isPlaying(), "keyframes in 1000ms, 50 frames");
+
+  ESP32_ISR_Servos.setPosition(servoIndex[0], 90);
+  ESP32_ISR_Servos.setPosition(servoIndex[1], 90);
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  ESP32_ISR_Servos.playSequence(keyframes, sizeof(keyframes), false, 200);
+  runSequence(widths, servoPins[0], servoPins[1], 1000);
+
+  check(checkSequence(widths, 25, slack), "keyframes at 200%, 25 frames");
+
+  // Looping: servo 1 jumps back to 180 at the start of each pass
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  ESP32_ISR_Servos.playSequence(keyframes, sizeof(keyframes), true);
+  runSequence(widths, servoPins[0], servoPins[1], 160);
+
+  int     passes  = 0;
+  double  top     = 2450 - ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+
+  for (size_t index = 1; index < widths[1].size(); index++)
+    passes += (widths[1][index] > top) && (widths[1][index - 1] < top);
+
+  bool playing = ESP32_ISR_Servos.isPlaying();
+
+  ESP32_ISR_Servos.stopSequence();
+
+  printf("  %d passes in 160 frames\n", passes);
+
+  check( playing && (passes == 4) && !ESP32_ISR_Servos.isPlaying() && !ESP32_ISR_Servos.isMoving(servoIndex[0])
+         && !ESP32_ISR_Servos.isMoving(servoIndex[1]), "looping keyframes, stopSequence()");
+
+  check(!ESP32_ISR_Servos.playSequence(keyframes, 5), "truncated sequence refused");
+
+  deleteAll(servoIndex, 2);
+}
+
+// Digital servos refreshed every 3333uS next to a standard one, with changes taking effect at the next subframe
+static void refreshRates()
+{
+  int8_t  servoIndex[3];
+  double  stepUs = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+
+  printf("\nRefresh rates\n");
+
+  servoIndex[0] = ESP32_ISR_Servos.setupServo(servoPins[0], 800, 2450, ISR_SERVO_BACKEND_ISR, 3000);
+  servoIndex[1] = ESP32_ISR_Servos.setupServo(servoPins[1], 800, 2450, ISR_SERVO_BACKEND_ISR);
+
+  check( (servoIndex[0] >= 0) && (ESP32_ISR_Servos.getRefreshInterval(servoIndex[0]) == REFRESH_INTERVAL / 6)
+         && (ESP32_ISR_Servos.getRefreshInterval(servoIndex[1]) == REFRESH_INTERVAL), "3000uS rounded up to 3333uS");
+
+  check( (ESP32_ISR_Servos.setupServo(servoPins[2], 800, 2450, ISR_SERVO_BACKEND_ISR, 2000) < 0)
+         && (ESP32_ISR_Servos.setupServo(servoPins[2], 800, 2450, ISR_SERVO_BACKEND_ISR, 4000) < 0)
+         && (ESP32_ISR_Servos.setupServo(servoPins[2], 800, 2450, ISR_SERVO_BACKEND_LEDC, 4000) < 0),
+         "refused: too fast, 5 pulses next to 6, LEDC");
+
+  // 256 and 259 pulses per frame, not wrapped to 0 and 3
+  check( (ESP32_ISR_Servos.setupServo(servoPins[2], 800, 2450, ISR_SERVO_BACKEND_RMT, 78) < 0)
+         && (ESP32_ISR_Servos.setupServo(servoPins[2], 800, 2450, ISR_SERVO_BACKEND_ISR, 77) < 0),
+         "refused: far too fast");
+
+  for (int stagger = 0; stagger < 2; stagger++)
+  {
+    ESP32_ISR_Servos.setStaggered(stagger);
+    ESP32_ISR_Servos.setPosition(servoIndex[0], 45);
+    ESP32_ISR_Servos.setPosition(servoIndex[1], 135);
+
+    sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+    sim::clear();
+    sim::runUntil(sim::now + sim::us(5 * REFRESH_INTERVAL));
+
+    bool ok = checkPulses(servoPins[0], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[0]) / 1000.0, stepUs + 0.2,
+                          ISR_PERIOD_US / 6.0);
+
+    ok &= checkPulses(servoPins[1], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[1]) / 1000.0, stepUs + 0.2);
+
+    check(ok, stagger ? "pulses every 3333uS and 20000uS, staggered" : "pulses every 3333uS and 20000uS");
+  }
+
+  ESP32_ISR_Servos.setStaggered(false);
+
+  // Setter in the middle of a subframe: the next pulse of the fast servo already has the new width,
+  // and no pulse of either servo is torn by the switch of frames
+  double              latencyMax = 0;
+  std::set<uint32_t>  widthsNs[2];
+  bool                torn       = false;
+
+  for (int servo = 0; servo < 2; servo++)
+    widthsNs[servo].insert(ESP32_ISR_Servos.getPulseWidthNs(servoIndex[servo]));
+
+  for (int update = 0; update < 20; update++)
+  {
+    sim::clear();
+    sim::runUntil(sim::now + sim::us(1000 + rand() % 20000));
+
+    uint64_t  setAt = sim::now;
+    uint16_t  position = (update % 2) ? 30 : 150;
+
+    ESP32_ISR_Servos.setPosition(servoIndex[0], position);
+    ESP32_ISR_Servos.setPosition(servoIndex[1], 180 - position + update);
+
+    for (int servo = 0; servo < 2; servo++)
+      widthsNs[servo].insert(ESP32_ISR_Servos.getPulseWidthNs(servoIndex[servo]));
+
+    sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+    for (int servo = 0; servo < 2; servo++)
+    {
+      for (double width : pulseWidths(servoPins[servo]))
+      {
+        bool known = false;
+
+        for (uint32_t widthNs : widthsNs[servo])
+          known |= (fabs(width - widthNs / 1000.0) < 0.2);
+
+        torn |= !known;
+      }
+    }
+
+    double    widthUs = ESP32_ISR_Servos.getPulseWidthNs(servoIndex[0]) / 1000.0;
+    uint64_t  riseAt  = 0;
+
+    for (auto& edge : sim::edges)
+    {
+      if (edge.pin != servoPins[0])
+        continue;
+
+      if (edge.level)
+        riseAt = edge.t;
+      else if ( (riseAt >= setAt) && (fabs(sim::toUs(edge.t - riseAt) - widthUs) < 0.2) )
+        break;
+    }
+
+    latencyMax = fmax(latencyMax, sim::toUs(riseAt - setAt));
+  }
+
+  printf("  setPosition() to pulse latency max %.1f uS\n", latencyMax);
+
+  check(latencyMax <= ISR_PERIOD_US / 6.0 + stepUs, "fast servo updated at the next subframe");
+  check(!torn, "no torn pulses");
+
+  if (ISR_SERVO_RMT_CHANNELS > 0)
+  {
+    servoIndex[2] = ESP32_ISR_Servos.setupServo(servoPins[2], 800, 2450, ISR_SERVO_BACKEND_RMT, 5000);
+
+    ESP32_ISR_Servos.setPosition(servoIndex[2], 90);
+
+    sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+    sim::clear();
+    sim::runUntil(sim::now + sim::us(5 * REFRESH_INTERVAL));
+
+    check( (servoIndex[2] >= 0) && checkPulses(servoPins[2], ESP32_ISR_Servos.getPulseWidthNs(servoIndex[2]) / 1000.0, 0.2,
+                                               5000), "RMT pulses every 5000uS");
+
+    deleteAll(&servoIndex[2], 1);
+  }
+
+  deleteAll(servoIndex, 2);
+
+  // Staggered slot 4 clamped to end within subframe 0 of a servo every 5000uS, with setters during its pulse:
+  // its falling edge must not wait for the boundary, where the ISR may swap in the new frame
+  int8_t slotIndex[5];
+
+  ESP32_ISR_Servos.setStaggered(true);
+
+  for (int index = 0; index < 5; index++)
+    slotIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], MIN_PULSE_WIDTH, MAX_PULSE_WIDTH,
+                                                   ISR_SERVO_BACKEND_ISR, (index == 0) ? 5000 : REFRESH_INTERVAL);
+
+  ESP32_ISR_Servos.setPosition(slotIndex[4], 180);
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+
+  // Setters drifting by 1300uS per frame across the whole frame
+  for (int update = 0; update < 40; update++)
+  {
+    sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL + 1300));
+
+    ESP32_ISR_Servos.setPosition(slotIndex[0], (update % 2) ? 0 : 180);
+    ESP32_ISR_Servos.setPosition(slotIndex[4], (update % 2) ? 180 : 0);
+  }
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+
+  double    highMax = 0;
+  uint64_t  riseAt  = 0;
+
+  for (auto& edge : sim::edges)
+  {
+    if (edge.pin != servoPins[4])
+      continue;
+
+    if (edge.level)
+      riseAt = edge.t;
+    else if (riseAt)
+      highMax = fmax(highMax, sim::toUs(edge.t - riseAt));
+  }
+
+  printf("  longest pulse of the clamped slot %.1f uS\n", highMax);
+
+  check( (slotIndex[4] == 4) && (highMax > 0) && (highMax <= MAX_PULSE_WIDTH + stepUs + 0.2),
+         "clamped staggered pulses end within their subframe");
+
+  ESP32_ISR_Servos.setStaggered(false);
+
+  deleteAll(slotIndex, 5);
+
+  // Fast servo set up and deleted in the middle of frames: the frames with other subframes only swap in at the
+  // frame start, so the standard servo keeps its period
+  int8_t standard = ESP32_ISR_Servos.setupServo(servoPins[1], 800, 2450, ISR_SERVO_BACKEND_ISR);
+
+  ESP32_ISR_Servos.setPosition(standard, 90);
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+
+  for (int update = 0; update < 10; update++)
+  {
+    sim::runUntil(sim::now + sim::us(1000 + rand() % 20000));
+
+    int8_t fast = ESP32_ISR_Servos.setupServo(servoPins[0], 800, 2450, ISR_SERVO_BACKEND_ISR, 3000);
+
+    sim::runUntil(sim::now + sim::us(1000 + rand() % 20000));
+
+    deleteAll(&fast, 1);
+  }
+
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  check(checkPulses(servoPins[1], ESP32_ISR_Servos.getPulseWidthNs(standard) / 1000.0, stepUs + 0.2),
+        "subframes changed at the frame start only");
+
+  deleteAll(&standard, 1);
+
+  // Staggered LEDC slot 3, next to a fast ISR servo: offset over the LEDC period, not clamped to an ISR subframe
+  if (ISR_SERVO_LEDC_CHANNELS > 0)
+  {
+    int8_t phased[4];
+
+    for (int index = 0; index < 4; index++)
+    {
+      phased[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450,
+                                                  (index == 3) ? ISR_SERVO_BACKEND_LEDC : ISR_SERVO_BACKEND_ISR,
+                                                  (index == 0) ? 3000 : REFRESH_INTERVAL);
+    }
+
+    // Rising edge of the LEDC servo in its period, in uS
+    auto risePhase = [&]()
+    {
+      sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+      sim::clear();
+      sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+
+      for (auto& edge : sim::edges)
+      {
+        if ( (edge.pin == servoPins[3]) && edge.level )
+          return fmod(sim::toUs(edge.t), REFRESH_INTERVAL);
+      }
+
+      return -1.0;
+    };
+
+    double unstaggered = risePhase();
+
+    ESP32_ISR_Servos.setStaggered(true);
+
+    double subframes = risePhase();
+
+    deleteAll(&phased[0], 1);
+
+    double frames = risePhase();
+
+    ESP32_ISR_Servos.setStaggered(false);
+
+    double offset = fmod(subframes - unstaggered + REFRESH_INTERVAL, REFRESH_INTERVAL);
+
+    printf("  LEDC slot 3 offset %.1f uS\n", offset);
+
+    check( (phased[3] == 3) && (unstaggered >= 0) && (fabs(offset - 3 * ISR_SERVO_STAGGER_STEP) < 1)
+           && (fabs(frames - subframes) < 1), "staggered LEDC offset over its own period, whatever the subframes");
+
+    deleteAll(phased, 4);
+  }
+}
+
+// ISR counters of getStats(), without and with ISR latency
+static void isrStats()
+{
+  int8_t            servoIndex[NUM_SERVOS];
+  isr_servo_stats_t stats;
+
+  printf("\nISR stats\n");
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], index * 30);
+  }
+
+  uint32_t latency  = sim::isrLatency;
+  uint32_t jitter   = sim::isrJitter;
+
+  for (int late = 0; late < 2; late++)
+  {
+    // 10uS late, every ISR run or in tick mode every few runs
+    sim::isrLatency = late ? 800 : 0;
+    sim::isrJitter  = late ? 800 : 0;
+
+    sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+    ESP32_ISR_Servos.resetStats();
+    sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+    sim::clear();
+    sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+    ESP32_ISR_Servos.getStats(stats);
+
+    printf("  %s: %u calls, %u frames, cycles %u / %u / %u, latency max %u nS, %u late, %u missed ticks\n",
+           late ? "late" : "on time", stats.isrCalls, stats.frames, stats.isrCyclesMin, stats.isrCyclesAvg,
+           stats.isrCyclesMax, stats.latencyMaxNs, stats.lateRuns, stats.missedTicks);
+
+    // Ticks missed in tick mode stretch the frames. The simulated CPU cycles only advance on counter reads,
+    // which the tick ISR never does
+    bool ok = (stats.frames >= (late ? 8 : 10)) && (stats.frames <= 12) && (stats.isrCalls >= sim::isrCalls)
+              && (stats.isrCyclesMin <= stats.isrCyclesAvg) && (stats.isrCyclesAvg <= stats.isrCyclesMax)
+              && ( (stats.isrCyclesMax > 0) || !ISR_SERVO_USING_EDGE_SCHEDULING );
+
+    if (late)
+      check(ok && (stats.lateRuns > 0) && (stats.latencyMaxNs >= ISR_SERVO_LATE_US * 1000)
+            && (stats.latencyMaxNs <= 20000 + ISR_SERVO_COUNT_TO_NS(1)), "late ISR runs counted");
+    else
+      check(ok && (stats.lateRuns == 0) && (stats.missedTicks == 0), "ISR counters, no late run");
+  }
+
+  sim::isrLatency = latency;
+  sim::isrJitter  = jitter;
+
+  deleteAll(servoIndex, NUM_SERVOS);
+}
+
+// Output of ESP32_ISR_ServoLog::drain(), into a string
+struct LogCapture
+{
+  std::string text;
+
+  template<typename T> void print(const T& value)
+  {
+    text += HostSerial::toString(value);
+  }
+
+  void println()
+  {
+    text += "\n";
+  }
+};
+
+// Deferred log ring buffer: records kept in order, overflow dropped and counted, text formatted by drain()
+static void deferredLog()
+{
+  LogCapture  out;
+  bool        ok = true;
+
+  printf("\nDeferred log\n");
+
+  ESP32_ISR_ServoLog::drain(out);
+  ESP32_ISR_ServoLog::getDropped();
+  out.text.clear();
+
+  ESP32_ISR_ServoLog::write(true, "Idx =", (int8_t) 3);
+  ESP32_ISR_ServoLog::write(true, F("cnt ="), (uint16_t) 1800, ", pos =", 45.5f);
+  ESP32_ISR_ServoLog::write(false, "no mark");
+  ESP32_ISR_ServoLog::write(true, "neg", -7);
+
+  check(ESP32_ISR_ServoLog::drain(out) == 4, "log records drained");
+
+  // Strip the micros() stamps
+  std::string text;
+
+  for (size_t pos = 0; pos < out.text.size(); pos++)
+  {
+    if (out.text[pos] == '@')
+    {
+      while (pos < out.text.size() && out.text[pos] != ' ')
+        pos++;
+    }
+
+    text += out.text[pos];
+  }
+
+  check(text == "[ISR_SERVO]  Idx = 3\n[ISR_SERVO]  cnt = 1800 , pos = 45.500000\nno mark[ISR_SERVO]  neg -7\n",
+        "log records formatted");
+
+  // Fill more than the ring buffer, across the wrap around of the slots
+  for (int round = 0; round < 3; round++)
+  {
+    for (uint32_t index = 0; index < ISR_SERVO_LOG_SIZE + 5; index++)
+      ESP32_ISR_ServoLog::write(true, "seq", index);
+
+    out.text.clear();
+
+    ok = ok && (ESP32_ISR_ServoLog::drain(out, 10) == 10) && (ESP32_ISR_ServoLog::drain(out) == ISR_SERVO_LOG_SIZE - 10)
+         && (ESP32_ISR_ServoLog::getDropped() == 5) && (ESP32_ISR_ServoLog::drain(out) == 0);
+
+    ok = ok && (out.text.find(" seq 0\n") != std::string::npos)
+         && (out.text.find(" seq " + std::to_string(ISR_SERVO_LOG_SIZE - 1) + "\n") != std::string::npos)
+         && (out.text.find(" seq " + std::to_string(ISR_SERVO_LOG_SIZE) + "\n") == std::string::npos)
+         && (out.text.find(" seq 1\n") < out.text.find(" seq 2\n"));
+  }
+
+  check(ok, "log overflow dropped, order kept");
+}
+
+// Frame notification: the task wakes once per frame at its start, and its setPosition() lands in the next frame
+static void frameNotify()
+{
+  int8_t  servoIndex  = ESP32_ISR_Servos.setupServo(servoPins[0], 800, 2450, ISR_SERVO_BACKEND_ISR);
+  double  stepUs      = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+  bool    once        = true;
+  bool    aligned     = true;
+  bool    landed      = true;
+
+  printf("\nFrame notification\n");
+
+  ESP32_ISR_Servos.setPosition(servoIndex, 180);
+
+  double widthMax = ESP32_ISR_Servos.getPulseWidth(servoIndex);
+
+  ESP32_ISR_Servos.setPosition(servoIndex, 0);
+
+  double widthMin = ESP32_ISR_Servos.getPulseWidth(servoIndex);
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+
+  ESP32_ISR_Servos.setFrameNotify();
+  ESP32_ISR_Servos.waitFrame();
+  sim::clear();
+
+  // Toggle the position at each wake up, as a control task would
+  for (int frame = 0; frame < 10; frame++)
+  {
+    once = once && (ESP32_ISR_Servos.waitFrame() == 1);
+
+    ESP32_ISR_Servos.setPosition(servoIndex, (frame & 1) ? 180 : 0);
+  }
+
+  // Let the last position play
+  ESP32_ISR_Servos.waitFrame();
+
+  ESP32_ISR_Servos.setFrameNotify(NULL);
+
+  std::vector<uint64_t> wakeAt = sim::notifications;
+  uint64_t              yields = sim::isrYields;
+
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  check(once && (wakeAt.size() == 11) && (sim::notifications.size() == 11) && (yields == 11)
+        && (ESP32_ISR_Servos.waitFrame(25) == 0), "one notification per frame, none once stopped");
+
+  // Each wake up at the rising edge of its frame, with the position set at the previous wake up
+
+  for (size_t frame = 0; frame < wakeAt.size(); frame++)
+  {
+    int rise = -1;
+
+    for (size_t index = 0; index < sim::edges.size(); index++)
+    {
+      if ( (sim::edges[index].pin == servoPins[0]) && sim::edges[index].level && (sim::edges[index].t >= wakeAt[frame]) )
+      {
+        rise = index;
+        break;
+      }
+    }
+
+    if (rise < 0)
+    {
+      aligned = false;
+      break;
+    }
+
+    aligned = aligned && (sim::toUs(sim::edges[rise].t - wakeAt[frame]) <= stepUs)
+              && ( (frame == 0) || (fabs(sim::toUs(wakeAt[frame] - wakeAt[frame - 1]) - ISR_PERIOD_US) <= stepUs) );
+
+    for (size_t index = rise + 1; index < sim::edges.size(); index++)
+    {
+      if (sim::edges[index].pin == servoPins[0])
+      {
+        double width    = sim::toUs(sim::edges[index].t - sim::edges[rise].t);
+        double expected = ( (frame == 0) || (frame & 1) ) ? widthMin : widthMax;
+
+        landed = landed && (fabs(width - expected) <= stepUs);
+        break;
+      }
+    }
+  }
+
+  check(aligned, "notified at the start of each frame");
+  check(landed, "position set on wake up lands in the next frame");
+
+  deleteAll(&servoIndex, 1);
+}
+
+// Calibration table: nonlinear mapping with sub-degree positions, round trips through setPulseWidth(), trim and reverse
+static void calibration()
+{
+  const uint16_t  table[5]    = { 600, 1000, 1500, 2100, 2400 };
+  const uint16_t  wrong[3]    = { 1000, 2000, 1500 };
+  int8_t          servoIndex  = ESP32_ISR_Servos.setupServo(servoPins[0], 800, 2450, ISR_SERVO_BACKEND_ISR);
+  double          stepUs      = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+  bool            ok          = true;
+
+  printf("\nCalibration\n");
+
+  auto widthAt = [&](const uint16_t& centidegrees)
+  {
+    ESP32_ISR_Servos.setPositionCd(servoIndex, centidegrees);
+
+    return ESP32_ISR_Servos.getPulseWidthNs(servoIndex) / 1000.0;
+  };
+
+  check(ESP32_ISR_Servos.setCalibration(servoIndex, table, 5) && !ESP32_ISR_Servos.setCalibration(servoIndex, wrong, 3),
+        "calibration table accepted, non monotonic refused");
+
+  // Table points, between them, and sub-degree steps
+  const uint16_t  at[]      = { 0, 4500, 9000, 11250, 13500, 18000, 4550, 15750 };
+  const double    expected[] = { 600, 1000, 1500, 1800, 2100, 2400, 1000 + 500 * 50 / 4500.0, 2250 };
+
+  for (size_t index = 0; index < sizeof(at) / sizeof(at[0]); index++)
+    ok = ok && (fabs(widthAt(at[index]) - expected[index]) <= stepUs);
+
+  check(ok && (ESP32_ISR_Servos.getPosition(servoIndex) == 158), "nonlinear positions to pulse widths");
+
+  // Pulse width to position and back, within one count
+  for (uint16_t width = 600; width <= 2400; width += 37)
+  {
+    uint16_t  pulseWidth  = width;
+
+    ESP32_ISR_Servos.setPulseWidth(servoIndex, pulseWidth);
+
+    uint32_t  widthNs     = ESP32_ISR_Servos.getPulseWidthNs(servoIndex);
+
+    ok = ok && (fabs(widthAt(ESP32_ISR_Servos.getPositionCd(servoIndex)) - widthNs / 1000.0) <= stepUs);
+  }
+
+  check(ok, "pulse width to position round trips");
+
+  ESP32_ISR_Servos.setPosition(servoIndex, 90);
+
+  uint16_t  below   = 500;
+  bool      trimmed = ESP32_ISR_Servos.setTrim(servoIndex, 50)
+                      && (fabs(ESP32_ISR_Servos.getPulseWidthNs(servoIndex) / 1000.0 - 1550) <= stepUs)
+                      && ESP32_ISR_Servos.setPulseWidth(servoIndex, below) && (below == 650);
+
+  check(trimmed, "trim applied right away, limits moved");
+
+  ESP32_ISR_Servos.setReversed(servoIndex, true);
+
+  check( (fabs(widthAt(0) - 2450) <= stepUs) && (fabs(widthAt(4500) - 2150) <= stepUs)
+         && (ESP32_ISR_Servos.getPosition(servoIndex) == 45), "reversed");
+
+  // On the pin
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  check(checkPulses(servoPins[0], ESP32_ISR_Servos.getPulseWidthNs(servoIndex) / 1000.0, stepUs), "calibrated pulses");
+
+  deleteAll(&servoIndex, 1);
+}
+
+// Bulk setters: one call for all servos of a mask, published in the same frame, rejected as a whole on a wrong mask
+static void bulkUpdates()
+{
+  int8_t    servoIndex[NUM_SERVOS];
+  double    stepUs  = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+  uint32_t  mask    = 0;
+
+  printf("\nBulk updates\n");
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 0);
+
+    // Every other servo
+    if ( (index & 1) == 0 )
+      mask |= 1UL << servoIndex[index];
+  }
+
+  const uint16_t positions[3] = { 45, 90, 180 };
+  const uint16_t widths[3]    = { 500, 1500, 3000 };
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL + 7000));
+
+  bool ok = ESP32_ISR_Servos.setPositions(positions, mask);
+
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  int changeAt = firstChange(pulseWidths(servoPins[0]));
+
+  for (int index = 0; index < NUM_SERVOS; index++)
+  {
+    int expected = (index & 1) ? 0 : positions[index / 2];
+
+    ok = ok && (ESP32_ISR_Servos.getPosition(servoIndex[index]) == expected);
+
+    if ( (index & 1) == 0 )
+      ok = ok && (firstChange(pulseWidths(servoPins[index])) == changeAt);
+    else
+      ok = ok && (firstChange(pulseWidths(servoPins[index])) < 0);
+  }
+
+  check(ok && (changeAt > 0), "setPositions() servos of the mask set in the same frame, the others kept");
+
+  // A servo not set up anywhere in the mask => nothing changes
+  ok = !ESP32_ISR_Servos.setPositions(widths, mask | (1UL << (ESP32_ISR_Servo::MAX_SERVOS - 1)))
+       && !ESP32_ISR_Servos.setPositions(NULL, mask) && (ESP32_ISR_Servos.getPosition(servoIndex[0]) == 45);
+
+  check(ok, "wrong mask rejected as a whole");
+
+  ok = ESP32_ISR_Servos.setPulseWidths(widths, mask);
+
+  for (int index = 0; index < 3; index++)
+  {
+    double width = ESP32_ISR_Servos.getPulseWidthNs(servoIndex[2 * index]) / 1000.0;
+
+    ok = ok && (fabs(width - std::min(std::max((int) widths[index], 800), 2450)) <= stepUs);
+  }
+
+  // 1500 uS is 76 degrees, within one count
+  check(ok && (abs(ESP32_ISR_Servos.getPosition(servoIndex[2]) - 76) <= 1 + stepUs * 180 / 1650), "setPulseWidths() within min and max");
+
+  deleteAll(servoIndex, NUM_SERVOS);
+}
+
+// Pose stream over UDP on the loopback interface: stale and malformed packets dropped, the newest pose of a frame
+// published alone, acks echoed back
+static void netControl()
+{
+  int8_t              servoIndex[NUM_SERVOS];
+  uint32_t            mask    = 0;
+  HostUDP             server;
+  HostUDP             sender;
+  ESP32_ISR_ServoNet  net(ESP32_ISR_Servos);
+  uint8_t             packet[ISR_SERVO_NET_MAX_PACKET];
+  uint32_t            loopback = htonl(INADDR_LOOPBACK);
+  double              stepUs   = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+
+  printf("\nNetwork control\n");
+
+  if ( !server.begin(0, loopback) || !sender.begin(0, loopback) )
+  {
+    check(false, "loopback UDP sockets");
+    return;
+  }
+
+  for (int index = 0; index < 4; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 90);
+
+    mask |= 1UL << servoIndex[index];
+  }
+
+  const uint16_t  older[4]  = { 1000, 1100, 1200, 1300 };
+  const uint16_t  newer[4]  = { 2000, 1900, 1800, 1700 };
+  const uint16_t  stale[5]  = { 900, 900, 900, 900, 900 };
+
+  auto send = [&](const uint32_t& seq, const uint32_t& sendMask, const uint16_t* widths, const uint8_t& flags)
+  {
+    sender.beginPacket(loopback, server.localPort());
+    sender.write(packet, ESP32_ISR_ServoNet::encodePose(packet, seq, seq * 1000, sendMask, widths, flags));
+    sender.endPacket();
+  };
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL + 7000));
+
+  // Two poses in the same frame, then a late one and garbage
+  send(10, mask, older, 0);
+  send(12, mask, newer, 0);
+  send(11, mask, stale, 0);
+
+  sender.beginPacket(loopback, server.localPort());
+  sender.write((const uint8_t*) "hello", 5);
+  sender.endPacket();
+
+  isr_servo_net_stats_t stats;
+
+  bool ok = (net.poll(server) == 4);
+
+  net.getStats(stats);
+
+  check(ok && (stats.received == 4) && (stats.applied == 2) && (stats.stale == 1) && (stats.invalid == 1) &&
+        (stats.commits == 1) && (stats.lastSeq == 12), "stale and malformed packets dropped");
+
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  int changeAt = firstChange(pulseWidths(servoPins[0]));
+
+  ok = (changeAt > 0);
+
+  for (int index = 0; index < 4; index++)
+  {
+    std::vector<double> widths = pulseWidths(servoPins[index]);
+
+    ok = ok && (firstChange(widths) == changeAt) && (fabs(widths[changeAt] - newer[index]) <= stepUs)
+         && (fabs(widths[changeAt - 1] - widths[0]) <= 1);
+  }
+
+  check(ok, "newest pose of the frame published alone, all servos in the same frame");
+
+  // Acks, also for a pose with a servo not set up
+  uint32_t                seq;
+  uint32_t                timeUs;
+  isr_servo_net_status_t  status;
+  int                     length;
+
+  send(13, mask, older, ISR_SERVO_NET_FLAG_ACK);
+  net.poll(server);
+
+  length = sender.parsePacket();
+  ok     = (length > 0) && (sender.read(packet, length) == ISR_SERVO_NET_HEADER)
+           && ESP32_ISR_ServoNet::decodeAck(packet, length, seq, timeUs, status)
+           && (seq == 13) && (timeUs == 13000) && (status == ISR_SERVO_NET_APPLIED);
+
+  uint32_t widthNs = ESP32_ISR_Servos.getPulseWidthNs(servoIndex[0]);
+
+  send(14, mask | (1UL << (ESP32_ISR_Servo::MAX_SERVOS - 1)), stale, ISR_SERVO_NET_FLAG_ACK);
+  net.poll(server);
+
+  length = sender.parsePacket();
+  ok     = ok && (length > 0) && (sender.read(packet, length) == ISR_SERVO_NET_HEADER)
+           && ESP32_ISR_ServoNet::decodeAck(packet, length, seq, timeUs, status)
+           && (seq == 14) && (status == ISR_SERVO_NET_REJECTED)
+           && (ESP32_ISR_Servos.getPulseWidthNs(servoIndex[0]) == widthNs)
+           && (fabs(widthNs / 1000.0 - older[0]) <= stepUs);
+
+  check(ok, "acks echo sequence number, timestamp and status");
+
+  // A restarted sender is resynced after ISR_SERVO_NET_RESYNC_MS
+  send(1, mask, newer, 0);
+  net.poll(server);
+  net.getStats(stats);
+
+  ok = (stats.lastSeq == 13);
+
+  sim::runUntil(sim::now + sim::us(ISR_SERVO_NET_RESYNC_MS * 1000));
+
+  send(1, mask, newer, 0);
+  net.poll(server);
+  net.getStats(stats);
+
+  check(ok && (stats.lastSeq == 1) && (net.poll(server) == 0), "restarted sender resynced");
+
+  deleteAll(servoIndex, 4);
+}
+
+// Auto-idle: pulses stopped by the ISR after the last command, resumed by the next one
+static void autoIdle()
+{
+  int8_t  servoIndex[2];
+  bool    ok = true;
+
+  printf("\nAuto-idle\n");
+
+  // Leave the frames phase of the next tests as found
+  const uint64_t startAt = sim::now;
+
+  for (int index = 0; index < 2; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 60 + 60 * index);
+  }
+
+  ok = ESP32_ISR_Servos.setAutoIdle(servoIndex[0], 100) && !ESP32_ISR_Servos.isIdle(servoIndex[0]);
+
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  uint64_t busyCalls = sim::isrCalls;
+
+  // Held from now on
+  ESP32_ISR_Servos.setPosition(servoIndex[0], 90);
+
+  uint64_t lastAt = sim::now;
+
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  std::vector<double> idled = pulseWidths(servoPins[0]);
+  std::vector<double> held  = pulseWidths(servoPins[1]);
+
+  uint64_t lastRiseAt   = 0;
+  uint64_t heldRiseAt[2] = { 0, 0 };
+
+  for (auto& edge : sim::edges)
+  {
+    if ( (edge.pin == servoPins[0]) && edge.level )
+      lastRiseAt = edge.t;
+
+    if ( (edge.pin == servoPins[1]) && edge.level )
+    {
+      heldRiseAt[0] = heldRiseAt[1];
+      heldRiseAt[1] = edge.t;
+    }
+  }
+
+  double idleMs = sim::toUs(lastRiseAt - lastAt) / 1000;
+
+  printf("  last pulse %.1f ms after the last command, %d pulses\n", idleMs, (int) idled.size());
+
+  ok = ok && ESP32_ISR_Servos.isIdle(servoIndex[0]) && !ESP32_ISR_Servos.isIdle(servoIndex[1])
+       && (idled.size() >= 5) && (idled.size() <= 6) && (idleMs < 100) && (idleMs >= 100 - REFRESH_INTERVAL / 1000)
+       && (held.size() == 10) && (firstChange(held) < 0) && (sim::level(servoPins[0]) == LOW);
+
+  check(ok, "idle servo stopped by the ISR within a frame of its timeout, the other untouched");
+
+  // Fewer alarms once idle
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+  printf("  ISR calls per frame %llu busy, %llu idle\n", (unsigned long long) busyCalls,
+         (unsigned long long) sim::isrCalls);
+
+  if (ISR_SERVO_USING_EDGE_SCHEDULING)
+    check(sim::isrCalls < busyCalls, "no ISR calls for the edges of the idle servo");
+
+  // Commanded again
+  ESP32_ISR_Servos.setPosition(servoIndex[0], 30);
+
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  idled = pulseWidths(servoPins[0]);
+
+  ok = (idled.size() >= 2) && (firstChange(idled) < 0) && !ESP32_ISR_Servos.isIdle(servoIndex[0])
+       && (fabs(idled.back() - ESP32_ISR_Servos.getPulseWidthNs(servoIndex[0]) / 1000.0) < 0.2);
+
+  check(ok, "next setter resumes the pulses");
+
+  // Idle from the end of a move, not its start
+  ESP32_ISR_Servos.moveTo(servoIndex[0], 150, 200, ISR_SERVO_PROFILE_LINEAR);
+
+  sim::clear();
+
+  while (ESP32_ISR_Servos.updateMotion())
+    sim::runUntil(sim::now + sim::us(1000));
+
+  lastAt = sim::now;
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+
+  ok = !ESP32_ISR_Servos.isIdle(servoIndex[0]);
+
+  sim::runUntil(lastAt + sim::us(100000 + 2 * REFRESH_INTERVAL));
+
+  check(ok && ESP32_ISR_Servos.isIdle(servoIndex[0]), "idle timeout restarted by each step of a move");
+
+  // Not from the ISR
+  int8_t ledcIndex = ESP32_ISR_Servos.setupServo(servoPins[4], 800, 2450, ISR_SERVO_BACKEND_LEDC);
+
+  check(!ESP32_ISR_Servos.setAutoIdle(ledcIndex, 100), "no auto-idle on a LEDC servo");
+
+  ESP32_ISR_Servos.deleteServo(ledcIndex);
+  deleteAll(servoIndex, 2);
+
+  const uint64_t frame = heldRiseAt[1] - heldRiseAt[0];
+
+  sim::runUntil(startAt + ( (sim::now - startAt) / frame + 1 ) * frame);
+}
+
+#if ISR_SERVO_FAILSAFE
+//  Servos no longer commanded time out: the ISR parks, stops or holds them by itself, then the next setter restores them
+static void failsafe()
+{
+  const uint8_t   actions[4]  = { ISR_SERVO_FAILSAFE_PARK, ISR_SERVO_FAILSAFE_STOP, ISR_SERVO_FAILSAFE_HOLD,
+                                  ISR_SERVO_FAILSAFE_OFF };
+  int8_t          servoIndex[4];
+  double          stepUs      = ISR_SERVO_COUNT_TO_NS(1) / 1000.0;
+  bool            ok          = true;
+
+  printf("\nFailsafe\n");
+
+  for (int index = 0; index < 4; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], 800, 2450, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], 150);
+
+    ok = ok && ESP32_ISR_Servos.setFailsafe(servoIndex[index], 100, actions[index], 1200);
+  }
+
+  // Commanded every frame, then never again
+  uint64_t lastAt = 0;
+
+  for (int frame = 0; frame < 10; frame++)
+  {
+    sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+    ESP32_ISR_Servos.setPosition(servoIndex[0], 150);
+    ESP32_ISR_Servos.feed(servoIndex[1]);
+    ESP32_ISR_Servos.feedAll();
+
+    lastAt = sim::now;
+  }
+
+  ok = ok && !ESP32_ISR_Servos.isFailsafe(servoIndex[0]) && !ESP32_ISR_Servos.isFailsafe(servoIndex[1]);
+
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(10 * REFRESH_INTERVAL));
+
+  std::vector<double> parked  = pulseWidths(servoPins[0]);
+  std::vector<double> stopped = pulseWidths(servoPins[1]);
+  std::vector<double> held    = pulseWidths(servoPins[2]);
+  std::vector<double> free    = pulseWidths(servoPins[3]);
+
+  // Timed out from 100ms after the last command, within one frame
+  int       tripAt  = firstChange(parked);
+  uint64_t  riseAt  = 0;
+  int       pulse   = -1;
+
+  for (auto& edge : sim::edges)
+  {
+    if ( (edge.pin == servoPins[0]) && edge.level && (++pulse == tripAt) )
+      riseAt = edge.t;
+  }
+
+  double tripMs = sim::toUs(riseAt - lastAt) / 1000;
+
+  printf("  parked %.1f ms after the last command, %d pulses once stopped\n", tripMs, (int) stopped.size());
+
+  ok = ok && (tripAt > 0) && (tripMs >= 100) && (tripMs <= 100 + REFRESH_INTERVAL / 1000)
+       && (fabs(parked.back() - 1200) <= stepUs)
+       && (stopped.size() == (size_t) tripAt) && (firstChange(held) < 0) && (firstChange(free) < 0)
+       && (held.size() == 10) && (free.size() == 10);
+
+  for (int index = 0; index < 4; index++)
+    ok = ok && (ESP32_ISR_Servos.isFailsafe(servoIndex[index]) == (actions[index] != ISR_SERVO_FAILSAFE_OFF));
+
+  check(ok, "timed out servos parked, stopped or held by the ISR alone, the others untouched");
+
+  // Commanded again
+  ESP32_ISR_Servos.setPosition(servoIndex[0], 150);
+  ESP32_ISR_Servos.setPosition(servoIndex[1], 30);
+
+  sim::clear();
+  sim::runUntil(sim::now + sim::us(3 * REFRESH_INTERVAL));
+
+  parked  = pulseWidths(servoPins[0]);
+  stopped = pulseWidths(servoPins[1]);
+
+  ok = (parked.size() >= 2) && (stopped.size() >= 2) && (firstChange(parked) < 0) && (firstChange(stopped) < 0)
+       && !ESP32_ISR_Servos.isFailsafe(servoIndex[0]) && !ESP32_ISR_Servos.isFailsafe(servoIndex[1])
+       && ESP32_ISR_Servos.isFailsafe(servoIndex[2]);
+
+  check(ok, "next setter restores the commanded pulses");
+
+  // Not from the ISR
+  int8_t ledcIndex = ESP32_ISR_Servos.setupServo(servoPins[4], 800, 2450, ISR_SERVO_BACKEND_LEDC);
+
+  check(!ESP32_ISR_Servos.setFailsafe(ledcIndex, 100), "no failsafe on a LEDC servo");
+
+  ESP32_ISR_Servos.deleteServo(ledcIndex);
+  deleteAll(servoIndex, 4);
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1)
+    sim::isrLatency = atoi(argv[1]);
+
+  printf("%s, %s, ISR latency %u cycles\n", ESP32_ISR_SERVO_VERSION,
+         ISR_SERVO_USING_EDGE_SCHEDULING ? "edge scheduling" : "tick", sim::isrLatency);
+
+  staticPositions();
+  randomUpdates();
+  staggered();
+  hardwareBackends();
+  twoEngines();
+  largeEngine();
+  smoothMotion();
+  groupUpdates();
+  keyframePlayer();
+  refreshRates();
+  isrStats();
+  deferredLog();
+  frameNotify();
+  calibration();
+  bulkUpdates();
+  netControl();
+  autoIdle();
+#if ISR_SERVO_FAILSAFE
+  failsafe();
+#endif
+
+  printf("\n%d failed\n", failures);
+
+  return failures;
+}
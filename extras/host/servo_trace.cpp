@@ -0,0 +1,169 @@
+/****************************************************************************************************************************
+  extras/host/servo_trace.cpp
+  Pulse train capture and analysis for ESP32_ISR_Servo: pulse width error, frame period jitter, max ISR duration
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Usage:
+    servo_trace sim [-n servos] [-f frames] [-l latency] [-j jitter] [-o prefix]
+      Simulate servos at spread positions, with ISR latency + random 0 - jitter, in APB cycles (80 per uS).
+      Writes every pin edge to prefix.csv
+    servo_trace analyze trace.csv [-o prefix]
+      Analyze a trace captured on target, such as the Serial output of examples/ServoTrace
+
+  Both write the per-servo report to prefix_report.csv and stdout, and the pulse trains to prefix.vcd
+ *****************************************************************************************************************************/
+
+#include "ESP32_ISR_Servo.h"
+
+#include "sim.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string>
+
+static const uint8_t servoPins[] = { 2, 4, 5, 12, 13, 14, 15, 16, 17, 18, 19, 21, 22, 23, 25, 26 };
+
+static void simulate(trace::trace_t& trace, const int& numServos, const int& numFrames)
+{
+  int8_t servoIndex[ESP32_ISR_Servo::MAX_SERVOS];
+
+  for (int index = 0; index < numServos; index++)
+  {
+    servoIndex[index] = ESP32_ISR_Servos.setupServo(servoPins[index], MIN_PULSE_WIDTH, MAX_PULSE_WIDTH, ISR_SERVO_BACKEND_ISR);
+    ESP32_ISR_Servos.setPosition(servoIndex[index], index * 180 / numServos);
+
+    trace.expectedNs[servoPins[index]] = ESP32_ISR_Servos.getPulseWidthNs(servoIndex[index]);
+  }
+
+  sim::runUntil(sim::now + sim::us(2 * REFRESH_INTERVAL));
+  sim::clear();
+
+  // Also drain the trace ring buffer of the library, as a sketch would on target
+  isr_servo_trace_t entries[64];
+  uint32_t          traced    = 0;
+  uint32_t          maxCycles = 0;
+
+  ESP32_ISR_Servos.getTraceDropped();
+  ESP32_ISR_Servos.getTraceMaxIsrCycles();
+
+  for (int frame = 0; frame < numFrames; frame++)
+  {
+    sim::runUntil(sim::now + sim::us(REFRESH_INTERVAL));
+
+    uint16_t count;
+
+    while ( (count = ESP32_ISR_Servos.readTrace(entries, 64)) > 0 )
+      traced += count;
+
+    maxCycles = std::max(maxCycles, ESP32_ISR_Servos.getTraceMaxIsrCycles());
+  }
+
+  trace.isrMaxNs = (uint64_t) maxCycles * 1000 / sim::CPU_MHZ;
+
+  for (auto& edge : sim::edges)
+    trace.edges.push_back({ edge.t * 1000 / sim::CYCLES_PER_US, edge.pin, edge.level });
+
+  printf("# %s, %s, %d servos, %d frames, ISR latency %u + 0-%u cycles\n", ESP32_ISR_SERVO_VERSION,
+         ISR_SERVO_USING_EDGE_SCHEDULING ? "edge scheduling" : "tick", numServos, numFrames, sim::isrLatency, sim::isrJitter);
+  printf("# ISR calls %llu, ISR trace entries %u, dropped %u\n", (unsigned long long) sim::isrCalls, traced,
+         ESP32_ISR_Servos.getTraceDropped());
+}
+
+static void usage()
+{
+  fprintf(stderr, "servo_trace sim [-n servos] [-f frames] [-l latency] [-j jitter] [-o prefix]\n");
+  fprintf(stderr, "servo_trace analyze trace.csv [-o prefix]\n");
+  exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+    usage();
+
+  std::string mode      = argv[1];
+  std::string input;
+  std::string prefix    = "servo_trace";
+  int         numServos = 8;
+  int         numFrames = 500;
+  int         arg       = 2;
+
+  if (mode == "analyze")
+  {
+    if (argc < 3)
+      usage();
+
+    input = argv[arg++];
+  }
+  else if (mode != "sim")
+    usage();
+
+  for (; arg + 1 < argc; arg += 2)
+  {
+    std::string option = argv[arg];
+
+    if (option == "-n")
+      numServos = std::min(atoi(argv[arg + 1]), (int) sizeof(servoPins));
+    else if (option == "-f")
+      numFrames = atoi(argv[arg + 1]);
+    else if (option == "-l")
+      sim::isrLatency = atoi(argv[arg + 1]);
+    else if (option == "-j")
+      sim::isrJitter = atoi(argv[arg + 1]);
+    else if (option == "-o")
+      prefix = argv[arg + 1];
+    else
+      usage();
+  }
+
+  trace::trace_t trace;
+
+  if (mode == "sim")
+  {
+    simulate(trace, numServos, numFrames);
+
+    FILE* file = fopen((prefix + ".csv").c_str(), "w");
+
+    if (file)
+    {
+      trace::writeCSV(file, trace);
+      fclose(file);
+    }
+  }
+  else
+  {
+    FILE* file = fopen(input.c_str(), "r");
+
+    if (!file || !trace::readCSV(file, trace))
+    {
+      fprintf(stderr, "No edges in %s\n", input.c_str());
+      return 1;
+    }
+
+    fclose(file);
+  }
+
+  std::vector<trace::servo_report_t> reports = trace::analyze(trace);
+
+  trace::writeReport(stdout, trace, reports);
+
+  FILE* file = fopen((prefix + "_report.csv").c_str(), "w");
+
+  if (file)
+  {
+    trace::writeReport(file, trace, reports);
+    fclose(file);
+  }
+
+  file = fopen((prefix + ".vcd").c_str(), "w");
+
+  if (file)
+  {
+    trace::writeVCD(file, trace);
+    fclose(file);
+  }
+
+  return 0;
+}
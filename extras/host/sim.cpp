@@ -0,0 +1,636 @@
+/****************************************************************************************************************************
+  extras/host/sim.cpp
+  Host simulation of the ESP32 peripherals used by ESP32_ISR_Servo
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+ *****************************************************************************************************************************/
+
+#include "Arduino.h"
+#include "driver/timer.h"
+#include "driver/ledc.h"
+#include "driver/rmt.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "soc/gpio_reg.h"
+#include "hal/cpu_hal.h"
+#include "freertos/task.h"
+
+#include "sim.h"
+
+HostSerial Serial;
+
+namespace sim
+{
+  uint64_t now              = 0;
+  uint32_t isrLatency       = 0;
+  uint32_t isrJitter        = 0;
+  uint32_t counterReadCost  = 8;
+  uint64_t isrCalls         = 0;
+  uint64_t isrCycles        = 0;
+  uint64_t isrCyclesMax     = 0;
+  uint64_t regWrites        = 0;
+  uint64_t isrYields        = 0;
+  bool     recordEdges      = true;
+
+  std::vector<edge_t>   edges;
+  std::vector<uint64_t> notifications;
+
+  static uint8_t levels[64];
+
+  static void setLevel(const uint64_t& t, const uint8_t& pin, const uint8_t& value)
+  {
+    if (levels[pin] != value)
+    {
+      levels[pin] = value;
+
+      if (recordEdges)
+        edges.push_back({ t, pin, value });
+    }
+  }
+
+  uint8_t level(const uint8_t& pin)
+  {
+    return levels[pin];
+  }
+
+  void clear()
+  {
+    edges.clear();
+
+    isrCalls      = 0;
+    isrCycles     = 0;
+    isrCyclesMax  = 0;
+    regWrites     = 0;
+    isrYields     = 0;
+
+    notifications.clear();
+  }
+
+  //////////////////////////////////////////////////////
+
+  typedef struct
+  {
+    bool          used;
+    bool          started;
+    bool          alarmEnabled;
+    bool          autoReload;
+    bool          intrEnabled;
+    uint32_t      divider;
+    uint64_t      base;             // time of the last counter load
+    uint64_t      load;             // counter value at base
+    uint64_t      alarm;
+    timer_isr_t   callback;
+    void*         arg;
+  } sim_timer_t;
+
+  static sim_timer_t timers[2][2];
+
+  static uint64_t counter(const sim_timer_t& timer)
+  {
+    return timer.load + (now - timer.base) / timer.divider;
+  }
+
+  static bool alarmPending(const sim_timer_t& timer)
+  {
+    return timer.used && timer.started && timer.alarmEnabled && timer.intrEnabled && timer.callback &&
+           (timer.alarm >= timer.load);
+  }
+
+  static uint64_t alarmTime(const sim_timer_t& timer)
+  {
+    return timer.base + (timer.alarm - timer.load) * timer.divider;
+  }
+
+  static void fireTimer(sim_timer_t& timer)
+  {
+    uint64_t at = alarmTime(timer);
+
+    if (at > now)
+      now = at;
+
+    if (timer.autoReload)
+    {
+      timer.base = now;
+      timer.load = 0;
+    }
+
+    now += isrLatency;
+
+    // Deterministic pseudo-random jitter, same sequence on each run
+    if (isrJitter)
+    {
+      static uint32_t seed = 1;
+
+      seed  = seed * 1103515245 + 12345;
+      now  += (seed >> 8) % (isrJitter + 1);
+    }
+
+    uint64_t start    = now;
+    uint64_t oldAlarm = timer.alarm;
+
+    timer.alarmEnabled = false;
+
+    isrCalls++;
+
+    if (timer.callback(timer.arg))
+      isrYields++;
+
+    isrCycles += now - start;
+
+    if (now - start > isrCyclesMax)
+      isrCyclesMax = now - start;
+
+    // Like the IDF driver: alarm re-enabled only if changed by the callback, or with auto-reload
+    timer.alarmEnabled = (timer.alarm != oldAlarm) || timer.autoReload;
+
+    // An alarm value already passed never fires on a free-running counter
+    if (!timer.autoReload && (timer.alarm < counter(timer)))
+      timer.alarmEnabled = false;
+  }
+
+  //////////////////////////////////////////////////////
+
+  // LEDC channel: duty and hpoint latched at the start of each period, like ledc_update_duty()
+  typedef enum { LEDC_PERIOD = 0, LEDC_RISE, LEDC_FALL } ledc_state_t;
+
+  typedef struct
+  {
+    bool          on;
+    int           gpio;
+    uint32_t      duty;
+    uint32_t      hpoint;
+    uint32_t      nextDuty;
+    uint32_t      nextHpoint;
+    uint64_t      periodStart;
+    uint64_t      nextAt;
+    ledc_state_t  state;
+  } sim_ledc_t;
+
+  static sim_ledc_t ledc[SOC_LEDC_CHANNEL_NUM];
+  static uint32_t   ledcResolution  = 16;
+  static uint64_t   ledcPeriod      = 20000 * CYCLES_PER_US;
+
+  static void fireLEDC(sim_ledc_t& channel)
+  {
+    switch (channel.state)
+    {
+      case LEDC_PERIOD:
+        channel.periodStart = channel.nextAt;
+        channel.duty        = channel.nextDuty;
+        channel.hpoint      = channel.nextHpoint;
+
+        if (channel.duty > 0)
+        {
+          channel.state   = LEDC_RISE;
+          channel.nextAt  = channel.periodStart + ( (channel.hpoint * ledcPeriod) >> ledcResolution );
+        }
+        else
+          channel.nextAt  = channel.periodStart + ledcPeriod;
+
+        break;
+
+      case LEDC_RISE:
+        setLevel(channel.nextAt, channel.gpio, HIGH);
+
+        channel.state   = LEDC_FALL;
+        channel.nextAt  = channel.periodStart + ( ( (uint64_t) (channel.hpoint + channel.duty) * ledcPeriod ) >> ledcResolution );
+        break;
+
+      case LEDC_FALL:
+        setLevel(channel.nextAt, channel.gpio, LOW);
+
+        channel.state   = LEDC_PERIOD;
+        channel.nextAt  = channel.periodStart + ledcPeriod;
+        break;
+    }
+  }
+
+  //////////////////////////////////////////////////////
+
+  // RMT TX channel in loop mode: items read from channel memory one half at a time, a 0 duration loops to item 0
+  typedef struct
+  {
+    bool          on;
+    bool          loop;
+    int           gpio;
+    uint32_t      clkDiv;
+    rmt_item32_t  mem[64];
+    uint8_t       item;
+    uint8_t       half;
+    uint64_t      nextAt;
+  } sim_rmt_t;
+
+  static sim_rmt_t rmt[SOC_RMT_TX_CANDIDATES_PER_GROUP];
+
+  static void fireRMT(sim_rmt_t& channel)
+  {
+    for (int retry = 0; retry < 2; retry++)
+    {
+      if (channel.item >= 64)
+        channel.item = 0;
+
+      const rmt_item32_t& item = channel.mem[channel.item];
+
+      uint32_t duration = channel.half ? item.duration1 : item.duration0;
+      uint8_t  value    = channel.half ? item.level1    : item.level0;
+
+      if (duration == 0)
+      {
+        if (!channel.loop)
+        {
+          channel.on = false;
+          setLevel(channel.nextAt, channel.gpio, LOW);
+
+          return;
+        }
+
+        channel.item = 0;
+        channel.half = 0;
+
+        continue;
+      }
+
+      setLevel(channel.nextAt, channel.gpio, value);
+
+      channel.nextAt += (uint64_t) duration * channel.clkDiv;
+
+      if (channel.half)
+        channel.item++;
+
+      channel.half = !channel.half;
+
+      return;
+    }
+
+    // Only end markers => stop
+    channel.on = false;
+  }
+
+  //////////////////////////////////////////////////////
+
+  // Earliest pending event before or at t: a timer alarm, or a LEDC / RMT edge. Fires it and returns true
+  static bool fireNext(const uint64_t& t)
+  {
+    sim_timer_t*  nextTimer = nullptr;
+    sim_ledc_t*   nextLEDC  = nullptr;
+    sim_rmt_t*    nextRMT   = nullptr;
+    uint64_t      nextAt    = t + 1;
+
+    for (auto& group : timers)
+    {
+      for (auto& timer : group)
+      {
+        if (alarmPending(timer) && (alarmTime(timer) < nextAt))
+        {
+          nextAt    = alarmTime(timer);
+          nextTimer = &timer;
+        }
+      }
+    }
+
+    // Hardware channels switch first when at the same time as the alarm
+    for (auto& channel : ledc)
+    {
+      if (channel.on && (channel.nextAt <= t) && (channel.nextAt <= nextAt))
+      {
+        nextAt    = channel.nextAt;
+        nextLEDC  = &channel;
+        nextTimer = nullptr;
+      }
+    }
+
+    for (auto& channel : rmt)
+    {
+      if (channel.on && (channel.nextAt <= t) && (channel.nextAt <= nextAt))
+      {
+        nextAt    = channel.nextAt;
+        nextRMT   = &channel;
+        nextLEDC  = nullptr;
+        nextTimer = nullptr;
+      }
+    }
+
+    if (nextTimer)
+      fireTimer(*nextTimer);
+    else if (nextLEDC)
+      fireLEDC(*nextLEDC);
+    else if (nextRMT)
+      fireRMT(*nextRMT);
+    else
+      return false;
+
+    return true;
+  }
+
+  void runUntil(const uint64_t& t)
+  {
+    while (fireNext(t));
+
+    if (t > now)
+      now = t;
+  }
+
+  bool step()
+  {
+    sim_timer_t*  nextTimer = nullptr;
+
+    for (auto& group : timers)
+    {
+      for (auto& timer : group)
+      {
+        if (alarmPending(timer) && (!nextTimer || (alarmTime(timer) < alarmTime(*nextTimer))))
+          nextTimer = &timer;
+      }
+    }
+
+    if (!nextTimer)
+      return false;
+
+    uint64_t calls = isrCalls;
+
+    // Hardware channels up to the alarm, then the alarm itself
+    while ( (isrCalls == calls) && fireNext(alarmTime(*nextTimer)) );
+
+    return true;
+  }
+}
+
+using namespace sim;
+
+//////////////////////////////////////////////////////
+// driver/timer.h
+
+esp_err_t timer_init(timer_group_t group, timer_idx_t index, const timer_config_t* config)
+{
+  sim_timer_t& timer = timers[group][index];
+
+  memset(&timer, 0, sizeof(timer));
+
+  timer.used          = true;
+  timer.divider       = config->divider;
+  timer.autoReload    = config->auto_reload;
+  timer.alarmEnabled  = config->alarm_en;
+  timer.started       = config->counter_en;
+  timer.base          = now;
+
+  return ESP_OK;
+}
+
+esp_err_t timer_set_counter_value(timer_group_t group, timer_idx_t index, uint64_t value)
+{
+  timers[group][index].base = now;
+  timers[group][index].load = value;
+
+  return ESP_OK;
+}
+
+esp_err_t timer_set_alarm_value(timer_group_t group, timer_idx_t index, uint64_t value)
+{
+  timers[group][index].alarm = value;
+
+  return ESP_OK;
+}
+
+esp_err_t timer_enable_intr(timer_group_t group, timer_idx_t index)
+{
+  timers[group][index].intrEnabled = true;
+
+  return ESP_OK;
+}
+
+esp_err_t timer_isr_callback_add(timer_group_t group, timer_idx_t index, timer_isr_t handler, void* arg, int)
+{
+  timers[group][index].callback = handler;
+  timers[group][index].arg      = arg;
+
+  return ESP_OK;
+}
+
+esp_err_t timer_start(timer_group_t group, timer_idx_t index)
+{
+  timers[group][index].started  = true;
+  timers[group][index].base     = now;
+
+  return ESP_OK;
+}
+
+esp_err_t timer_group_intr_enable(timer_group_t group, timer_intr_t mask)
+{
+  for (int index = 0; index < 2; index++)
+  {
+    if (mask & (1 << index))
+      timers[group][index].intrEnabled = true;
+  }
+
+  return ESP_OK;
+}
+
+esp_err_t timer_group_intr_disable(timer_group_t group, timer_intr_t mask)
+{
+  for (int index = 0; index < 2; index++)
+  {
+    if (mask & (1 << index))
+      timers[group][index].intrEnabled = false;
+  }
+
+  return ESP_OK;
+}
+
+uint64_t timer_group_get_counter_value_in_isr(timer_group_t group, timer_idx_t index)
+{
+  now += counterReadCost;
+
+  return counter(timers[group][index]);
+}
+
+void timer_group_set_alarm_value_in_isr(timer_group_t group, timer_idx_t index, uint64_t value)
+{
+  timers[group][index].alarm = value;
+}
+
+//////////////////////////////////////////////////////
+// driver/ledc.h
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t* config)
+{
+  ledcResolution  = config->duty_resolution;
+  ledcPeriod      = 1000000ULL * CYCLES_PER_US / config->freq_hz;
+
+  return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t* config)
+{
+  sim_ledc_t& channel = ledc[config->channel];
+
+  memset(&channel, 0, sizeof(channel));
+
+  channel.on          = true;
+  channel.gpio        = config->gpio_num;
+  channel.nextDuty    = config->duty;
+  channel.nextHpoint  = config->hpoint;
+  channel.nextAt      = now;
+  channel.state       = LEDC_PERIOD;
+
+  return ESP_OK;
+}
+
+esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t, ledc_channel_t channel, uint32_t duty, uint32_t hpoint)
+{
+  ledc[channel].nextDuty    = duty;
+  ledc[channel].nextHpoint  = hpoint;
+
+  return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t, ledc_channel_t)
+{
+  return ESP_OK;
+}
+
+esp_err_t ledc_stop(ledc_mode_t, ledc_channel_t channel, uint32_t idle_level)
+{
+  ledc[channel].on = false;
+
+  setLevel(now, ledc[channel].gpio, idle_level);
+
+  return ESP_OK;
+}
+
+//////////////////////////////////////////////////////
+// driver/rmt.h
+
+esp_err_t rmt_config(const rmt_config_t* config)
+{
+  sim_rmt_t& channel = rmt[config->channel];
+
+  channel.on      = false;
+  channel.gpio    = config->gpio_num;
+  channel.clkDiv  = config->clk_div;
+  channel.loop    = config->tx_config.loop_en;
+
+  return ESP_OK;
+}
+
+esp_err_t rmt_fill_tx_items(rmt_channel_t channel, const rmt_item32_t* item, uint16_t item_num, uint16_t mem_offset)
+{
+  for (int index = 0; (index < item_num) && (mem_offset + index < 64); index++)
+    rmt[channel].mem[mem_offset + index] = item[index];
+
+  return ESP_OK;
+}
+
+esp_err_t rmt_tx_start(rmt_channel_t channel, bool)
+{
+  rmt[channel].on     = true;
+  rmt[channel].item   = 0;
+  rmt[channel].half   = 0;
+  rmt[channel].nextAt = now;
+
+  return ESP_OK;
+}
+
+esp_err_t rmt_tx_stop(rmt_channel_t channel)
+{
+  rmt[channel].on = false;
+
+  setLevel(now, rmt[channel].gpio, LOW);
+
+  return ESP_OK;
+}
+
+//////////////////////////////////////////////////////
+// Arduino.h, soc/soc.h
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  setLevel(now, pin, value);
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+unsigned long millis()
+{
+  return now / (1000 * CYCLES_PER_US);
+}
+
+unsigned long micros()
+{
+  return now / CYCLES_PER_US;
+}
+
+void delay(uint32_t ms)
+{
+  runUntil(now + (uint64_t) ms * 1000 * CYCLES_PER_US);
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+  return CPU_MHZ;
+}
+
+// The host is the only task
+struct tskTaskControlBlock
+{
+  uint32_t notifyCount;
+};
+
+static tskTaskControlBlock hostTask = { 0 };
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+  return &hostTask;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken)
+{
+  task->notifyCount++;
+  notifications.push_back(now);
+
+  if (woken)
+    *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCount, TickType_t ticks)
+{
+  uint64_t until = (ticks == portMAX_DELAY) ? UINT64_MAX : now + (uint64_t) ticks * portTICK_PERIOD_MS * 1000 * CYCLES_PER_US;
+
+  // Blocked: time runs, one ISR call at a time
+  while ( (hostTask.notifyCount == 0) && (now < until) && step() );
+
+  uint32_t count = hostTask.notifyCount;
+
+  if (clearCount)
+    hostTask.notifyCount = 0;
+  else if (count)
+    hostTask.notifyCount--;
+
+  return count;
+}
+
+uint32_t cpu_hal_get_cycle_count(void)
+{
+  return (uint32_t) (now * CPU_MHZ / CYCLES_PER_US);
+}
+
+void simRegWrite(uint32_t reg, uint32_t value)
+{
+  uint8_t base  = ( (reg == GPIO_OUT1_W1TS_REG) || (reg == GPIO_OUT1_W1TC_REG) ) ? 32 : 0;
+  uint8_t level = ( (reg == GPIO_OUT_W1TS_REG)  || (reg == GPIO_OUT1_W1TS_REG) ) ? HIGH : LOW;
+
+  regWrites++;
+
+  for (int bit = 0; bit < 32; bit++)
+  {
+    if (value & (1UL << bit))
+      setLevel(now, base + bit, level);
+  }
+}
@@ -0,0 +1,79 @@
+/****************************************************************************************************************************
+  extras/host/sim.h
+  Host simulation of the ESP32 peripherals used by ESP32_ISR_Servo
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Time is counted in APB clock cycles (80MHz). The hardware timers follow the IDF v4.4 driver semantics the library
+  relies on: the alarm is disabled when it fires, and only re-enabled after the callback if the callback changed it
+  or auto-reload is on. Each counter read from the ISR costs counterReadCost cycles, so busy-waits progress.
+  GPIO register writes, digitalWrite(), LEDC and RMT channels all record their edges with the same time base.
+ *****************************************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace sim
+{
+  const uint32_t CYCLES_PER_US = 80;
+
+  // CPU clock for cpu_hal_get_cycle_count()
+  const uint32_t CPU_MHZ       = 240;
+
+  typedef struct
+  {
+    uint64_t  t;            // APB cycles
+    uint8_t   pin;
+    uint8_t   level;
+  } edge_t;
+
+  // Current time, in APB cycles
+  extern uint64_t now;
+
+  // Cycles from the alarm to the callback, plus a random 0 - isrJitter cycles, and per counter read inside the callback
+  extern uint32_t isrLatency;
+  extern uint32_t isrJitter;
+  extern uint32_t counterReadCost;
+
+  // Number of callbacks, cycles spent in callbacks (latency excluded), and register writes to GPIO_OUT_W1TS/W1TC
+  extern uint64_t isrCalls;
+  extern uint64_t isrCycles;
+  extern uint64_t isrCyclesMax;
+  extern uint64_t regWrites;
+
+  // Callbacks returning true, to yield to a task they woke, and times of the notifications to the host task
+  extern uint64_t isrYields;
+  extern std::vector<uint64_t> notifications;
+
+  // All pin edges since start, or since the last clear(). Edges of LEDC / RMT channels switching while
+  // an ISR is running are appended after it: sort by t when order matters
+  extern std::vector<edge_t> edges;
+
+  // false => edges are not recorded, for long runs
+  extern bool recordEdges;
+
+  inline uint64_t us(const double& microsecs)
+  {
+    return (uint64_t) (microsecs * CYCLES_PER_US);
+  }
+
+  inline double toUs(const uint64_t& cycles)
+  {
+    return (double) cycles / CYCLES_PER_US;
+  }
+
+  // Advance time up to t, firing every timer alarm and hardware channel edge due on the way
+  void runUntil(const uint64_t& t);
+
+  // Advance to the next timer alarm and fire it, one ISR call. Returns false if no alarm is pending
+  bool step();
+
+  // Current output level of pin
+  uint8_t level(const uint8_t& pin);
+
+  // Clear recorded edges and counters, time and peripherals keep running
+  void clear();
+}
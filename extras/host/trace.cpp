@@ -0,0 +1,176 @@
+/****************************************************************************************************************************
+  extras/host/trace.cpp
+  Pulse train trace files and analysis for ESP32_ISR_Servo
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+ *****************************************************************************************************************************/
+
+#include "trace.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// Same as ESP32_ISR_Servo.hpp, for the position error in degrees
+#define TRACE_MIN_PULSE_WIDTH     544
+#define TRACE_MAX_PULSE_WIDTH     2400
+
+namespace trace
+{
+  bool readCSV(FILE* file, trace_t& trace)
+  {
+    char line[128];
+
+    trace.edges.clear();
+    trace.expectedNs.clear();
+    trace.isrMaxNs = 0;
+
+    while (fgets(line, sizeof(line), file))
+    {
+      unsigned long long  ns;
+      unsigned int        pin, level, value;
+
+      if (line[0] == '#')
+      {
+        if (sscanf(line, "#expect,%u,%u", &pin, &value) == 2)
+          trace.expectedNs[pin] = value;
+        else if (sscanf(line, "#isr_max_ns,%u", &value) == 1)
+          trace.isrMaxNs = std::max(trace.isrMaxNs, (uint32_t) value);
+      }
+      else if (sscanf(line, "%llu,%u,%u", &ns, &pin, &level) == 3)
+        trace.edges.push_back({ ns, (uint8_t) pin, (uint8_t) (level != 0) });
+    }
+
+    // Hardware channels may be logged slightly out of order
+    std::stable_sort(trace.edges.begin(), trace.edges.end(), [](const edge_t& a, const edge_t& b)
+    {
+      return a.ns < b.ns;
+    });
+
+    return !trace.edges.empty();
+  }
+
+  void writeCSV(FILE* file, const trace_t& trace)
+  {
+    fprintf(file, "# time_ns,pin,level\n");
+
+    for (auto& expected : trace.expectedNs)
+      fprintf(file, "#expect,%d,%u\n", expected.first, expected.second);
+
+    fprintf(file, "#isr_max_ns,%u\n", trace.isrMaxNs);
+
+    for (auto& edge : trace.edges)
+      fprintf(file, "%llu,%u,%u\n", (unsigned long long) edge.ns, edge.pin, edge.level);
+  }
+
+  std::vector<servo_report_t> analyze(const trace_t& trace)
+  {
+    std::map<int, std::vector<double>>  widths;
+    std::map<int, std::vector<double>>  periods;
+    std::map<int, uint64_t>             riseAt;
+
+    for (auto& edge : trace.edges)
+    {
+      if (edge.level)
+      {
+        if (riseAt.count(edge.pin))
+          periods[edge.pin].push_back( (edge.ns - riseAt[edge.pin]) / 1000.0 );
+
+        riseAt[edge.pin] = edge.ns;
+      }
+      else if (riseAt.count(edge.pin))
+        widths[edge.pin].push_back( (edge.ns - riseAt[edge.pin]) / 1000.0 );
+    }
+
+    std::vector<servo_report_t> reports;
+
+    for (auto& pinWidths : widths)
+    {
+      servo_report_t  report;
+      auto&           width   = pinWidths.second;
+      auto&           period  = periods[pinWidths.first];
+
+      memset(&report, 0, sizeof(report));
+
+      report.pin        = pinWidths.first;
+      report.pulses     = width.size();
+      report.widthMinUs = *std::min_element(width.begin(), width.end());
+      report.widthMaxUs = *std::max_element(width.begin(), width.end());
+
+      for (double value : width)
+        report.widthMeanUs += value / width.size();
+
+      auto expected = trace.expectedNs.find(report.pin);
+
+      if (expected != trace.expectedNs.end())
+      {
+        report.expectedUs   = expected->second / 1000.0;
+        report.errorMaxUs   = std::max(fabs(report.widthMinUs - report.expectedUs), fabs(report.widthMaxUs - report.expectedUs));
+        report.errorMaxDeg  = report.errorMaxUs * 180.0 / (TRACE_MAX_PULSE_WIDTH - TRACE_MIN_PULSE_WIDTH);
+      }
+
+      if (!period.empty())
+      {
+        for (double value : period)
+          report.periodMeanUs += value / period.size();
+
+        for (double value : period)
+          report.periodStdDevUs += (value - report.periodMeanUs) * (value - report.periodMeanUs) / period.size();
+
+        report.periodStdDevUs = sqrt(report.periodStdDevUs);
+        report.periodJitterUs = *std::max_element(period.begin(), period.end()) - *std::min_element(period.begin(), period.end());
+      }
+
+      reports.push_back(report);
+    }
+
+    return reports;
+  }
+
+  void writeReport(FILE* file, const trace_t& trace, const std::vector<servo_report_t>& reports)
+  {
+    fprintf(file, "pin,pulses,expected_us,width_min_us,width_max_us,width_mean_us,error_max_us,error_max_deg,"
+            "period_mean_us,period_jitter_us,period_stddev_us,isr_max_us\n");
+
+    for (auto& report : reports)
+    {
+      fprintf(file, "%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", report.pin, report.pulses,
+              report.expectedUs, report.widthMinUs, report.widthMaxUs, report.widthMeanUs, report.errorMaxUs, report.errorMaxDeg,
+              report.periodMeanUs, report.periodJitterUs, report.periodStdDevUs, trace.isrMaxNs / 1000.0);
+    }
+  }
+
+  // Value Change Dump, one wire per pin, 1ns timescale, for GTKWave or PulseView
+  void writeVCD(FILE* file, const trace_t& trace)
+  {
+    std::map<int, char> ids;
+
+    for (auto& edge : trace.edges)
+    {
+      if (!ids.count(edge.pin))
+        ids[edge.pin] = '!' + ids.size();
+    }
+
+    fprintf(file, "$timescale 1ns $end\n$scope module esp32 $end\n");
+
+    for (auto& id : ids)
+      fprintf(file, "$var wire 1 %c gpio%d $end\n", id.second, id.first);
+
+    fprintf(file, "$upscope $end\n$enddefinitions $end\n");
+
+    uint64_t  base = trace.edges.empty() ? 0 : trace.edges.front().ns;
+    uint64_t  last = UINT64_MAX;
+
+    for (auto& edge : trace.edges)
+    {
+      if (edge.ns != last)
+      {
+        fprintf(file, "#%llu\n", (unsigned long long) (edge.ns - base));
+        last = edge.ns;
+      }
+
+      fprintf(file, "%u%c\n", edge.level, ids[edge.pin]);
+    }
+  }
+}
@@ -0,0 +1,59 @@
+/****************************************************************************************************************************
+  extras/host/trace.h
+  Pulse train trace files and analysis for ESP32_ISR_Servo
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Trace CSV, as written by servo_trace or printed by examples/ServoTrace:
+    time_ns,pin,level               one line per pin edge, time increasing
+    #expect,pin,width_ns            programmed pulse width of pin, for the width error
+    #isr_max_ns,ns                  longest ISR run
+ *****************************************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <vector>
+
+namespace trace
+{
+  typedef struct
+  {
+    uint64_t  ns;
+    uint8_t   pin;
+    uint8_t   level;
+  } edge_t;
+
+  typedef struct
+  {
+    std::vector<edge_t>       edges;
+    std::map<int, uint32_t>   expectedNs;       // per pin
+    uint32_t                  isrMaxNs;
+  } trace_t;
+
+  typedef struct
+  {
+    int       pin;
+    int       pulses;
+    double    expectedUs;                       // 0 if unknown
+    double    widthMinUs;
+    double    widthMaxUs;
+    double    widthMeanUs;
+    double    errorMaxUs;                       // largest | width - expected |
+    double    errorMaxDeg;                      // errorMaxUs over a MIN_PULSE_WIDTH - MAX_PULSE_WIDTH / 180 degrees servo
+    double    periodMeanUs;
+    double    periodJitterUs;                   // max - min
+    double    periodStdDevUs;
+  } servo_report_t;
+
+  bool readCSV(FILE* file, trace_t& trace);
+  void writeCSV(FILE* file, const trace_t& trace);
+
+  std::vector<servo_report_t> analyze(const trace_t& trace);
+
+  void writeReport(FILE* file, const trace_t& trace, const std::vector<servo_report_t>& reports);
+  void writeVCD(FILE* file, const trace_t& trace);
+}
@@ -0,0 +1,150 @@
+/****************************************************************************************************************************
+  extras/host/udp.h
+  UDP socket with the WiFiUDP interface used by ESP32_ISR_ServoNet::poll(), over POSIX sockets
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Non-blocking: parsePacket() returns 0 at once when no packet is pending. Addresses are IPv4, in network byte order
+ *****************************************************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+class HostUDP
+{
+  public:
+    HostUDP() : fd(-1), length(0), pos(0), sendLength(0)
+    {
+      memset(&remote, 0, sizeof(remote));
+      memset(&dest, 0, sizeof(dest));
+    }
+
+    ~HostUDP()
+    {
+      stop();
+    }
+
+    // Listen on port of address (INADDR_ANY by default), 0 => any free port, see localPort(). returns 1 on success
+    uint8_t begin(const uint16_t& port, const uint32_t& address = htonl(INADDR_ANY))
+    {
+      stop();
+
+      if ( (fd = socket(AF_INET, SOCK_DGRAM, 0)) < 0 )
+        return 0;
+
+      sockaddr_in local;
+
+      memset(&local, 0, sizeof(local));
+      local.sin_family      = AF_INET;
+      local.sin_port        = htons(port);
+      local.sin_addr.s_addr = address;
+
+      if ( (bind(fd, (sockaddr*) &local, sizeof(local)) < 0) || (fcntl(fd, F_SETFL, O_NONBLOCK) < 0) )
+      {
+        stop();
+        return 0;
+      }
+
+      return 1;
+    }
+
+    void stop()
+    {
+      if (fd >= 0)
+        close(fd);
+
+      fd = -1;
+    }
+
+    uint16_t localPort()
+    {
+      sockaddr_in local;
+      socklen_t   size = sizeof(local);
+
+      if ( (fd < 0) || (getsockname(fd, (sockaddr*) &local, &size) < 0) )
+        return 0;
+
+      return ntohs(local.sin_port);
+    }
+
+    // Receive the next pending packet, dropping the unread rest of the previous one. returns its length, 0 if none
+    int parsePacket()
+    {
+      socklen_t size = sizeof(remote);
+
+      pos     = 0;
+      length  = (fd < 0) ? -1 : recvfrom(fd, buffer, sizeof(buffer), 0, (sockaddr*) &remote, &size);
+
+      if (length < 0)
+        length = 0;
+
+      return length;
+    }
+
+    int read(uint8_t* data, const size_t& size)
+    {
+      int count = ((int) size < length - pos) ? (int) size : length - pos;
+
+      memcpy(data, buffer + pos, count);
+      pos += count;
+
+      return count;
+    }
+
+    uint32_t remoteIP()
+    {
+      return remote.sin_addr.s_addr;
+    }
+
+    uint16_t remotePort()
+    {
+      return ntohs(remote.sin_port);
+    }
+
+    int beginPacket(const uint32_t& address, const uint16_t& port)
+    {
+      memset(&dest, 0, sizeof(dest));
+      dest.sin_family       = AF_INET;
+      dest.sin_port         = htons(port);
+      dest.sin_addr.s_addr  = address;
+
+      sendLength = 0;
+
+      return 1;
+    }
+
+    size_t write(const uint8_t* data, const size_t& size)
+    {
+      size_t count = (size < sizeof(sendBuffer) - sendLength) ? size : sizeof(sendBuffer) - sendLength;
+
+      memcpy(sendBuffer + sendLength, data, count);
+      sendLength += count;
+
+      return count;
+    }
+
+    int endPacket()
+    {
+      return (fd >= 0) && (sendto(fd, sendBuffer, sendLength, 0, (sockaddr*) &dest, sizeof(dest)) == (ssize_t) sendLength);
+    }
+
+  private:
+    int           fd;
+    sockaddr_in   remote;
+    sockaddr_in   dest;
+
+    uint8_t       buffer[1500];
+    int           length;
+    int           pos;
+
+    uint8_t       sendBuffer[1500];
+    size_t        sendLength;
+};
@@ -212,11 +212,42 @@ class ESP32TimerInterrupt
     
     //xQueueHandle      s_timer_queue;
 
+    // Program the timer, alarm at alarmValue (in timer ticks), attach callback and start counting from 0.
+    // callback gets arg, or the timer number if arg is NULL
+    bool startTimer(const uint64_t& alarmValue, timer_callback callback, void* arg = NULL)
+    {
+      timer_init(_timerGroup, _timerIndex, &stdConfig);
+
+      // Counter value to 0 => counting up to alarm value as .counter_dir == TIMER_COUNT_UP
+      timer_set_counter_value(_timerGroup, _timerIndex , 0x00000000ULL);
+
+      timer_set_alarm_value(_timerGroup, _timerIndex, alarmValue);
+
+      // enable interrupts for _timerGroup, _timerIndex
+      timer_enable_intr(_timerGroup, _timerIndex);
+
+      _callback = callback;
+
+      // Register the ISR handler
+      // If the intr_alloc_flags value ESP_INTR_FLAG_IRAM is set, the handler function must be declared with IRAM_ATTR attribute
+      // and can only call functions in IRAM or ROM. It cannot call other timer APIs.
+      //timer_isr_register(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, ESP_INTR_FLAG_IRAM, NULL);
+      // The interrupt is allocated on the core calling this function
+      timer_isr_callback_add(_timerGroup, _timerIndex, _callback, arg ? arg : (void *) (uint32_t) _timerNo, 0);
+
+      timer_start(_timerGroup, _timerIndex);
+
+      return true;
+    }
+
   public:
 
-    ESP32TimerInterrupt(uint8_t timerNo)
+    // divider: hardware timer clock divider (2-65536), counter runs at (TIMER_BASE_CLK / divider)
+    ESP32TimerInterrupt(uint8_t timerNo, const uint32_t& divider = TIMER_DIVIDER)
     {     
       _callback = NULL;
+
+      stdConfig.divider = divider;
         
       if (timerNo < MAX_ESP32_NUM_TIMERS)
       {
@@ -246,13 +277,13 @@ class ESP32TimerInterrupt
 
     // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
     // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
-    bool setFrequency(const float& frequency, timer_callback callback)
+    bool setFrequency(const float& frequency, timer_callback callback, void* arg = NULL)
     {
       if (_timerNo < MAX_ESP32_NUM_TIMERS)
       {      
         // select timer frequency is 1MHz for better accuracy. We don't use 16-bit prescaler for now.
         // Will use later if very low frequency is needed.
-        _frequency  = TIMER_BASE_CLK / TIMER_DIVIDER;   //1000000;
+        _frequency  = TIMER_BASE_CLK / stdConfig.divider;   //1000000;
         _timerCount = (uint64_t) _frequency / frequency;
         // count up
 
@@ -278,27 +309,7 @@ class ESP32TimerInterrupt
         ISR_SERVO_LOGERROR1(F("timer_set_alarm_value ="), TIMER_SCALE / frequency);
 #endif
 
-        timer_init(_timerGroup, _timerIndex, &stdConfig);
-        
-        // Counter value to 0 => counting up to alarm value as .counter_dir == TIMER_COUNT_UP
-        timer_set_counter_value(_timerGroup, _timerIndex , 0x00000000ULL);       
-        
-        timer_set_alarm_value(_timerGroup, _timerIndex, TIMER_SCALE / frequency);
-               
-        // enable interrupts for _timerGroup, _timerIndex
-        timer_enable_intr(_timerGroup, _timerIndex);
-        
-        _callback = callback;
-        
-        // Register the ISR handler       
-        // If the intr_alloc_flags value ESP_INTR_FLAG_IRAM is set, the handler function must be declared with IRAM_ATTR attribute
-        // and can only call functions in IRAM or ROM. It cannot call other timer APIs.
-       //timer_isr_register(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, ESP_INTR_FLAG_IRAM, NULL);
-        timer_isr_callback_add(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, 0);
-
-        timer_start(_timerGroup, _timerIndex);
-  
-        return true;
+        return startTimer(_frequency / frequency, callback, arg);
       }
       else
       {
@@ -314,9 +325,46 @@ class ESP32TimerInterrupt
 
     // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
     // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
-    bool attachInterruptInterval(const unsigned long& interval, timer_callback callback)
+    bool attachInterruptInterval(const unsigned long& interval, timer_callback callback, void* arg = NULL)
+    {
+      return setFrequency( (float) ( 1000000.0f / interval), callback, arg);
+    }
+
+    // Free-running counter (no auto-reload). The first alarm fires when the counter reaches alarmValue (in timer ticks),
+    // then the callback must program the next one with setAlarmInISR(). Used by the edge-scheduled Servo ISR
+    bool attachInterruptAlarm(const uint64_t& alarmValue, timer_callback callback, void* arg = NULL)
+    {
+      if (_timerNo < MAX_ESP32_NUM_TIMERS)
+      {
+        stdConfig.auto_reload = TIMER_AUTORELOAD_DIS;
+
+        ISR_SERVO_LOGERROR3(F("ESP32_TimerInterrupt: _timerNo ="), _timerNo, F(", first alarm ="), (uint32_t) alarmValue);
+
+        return startTimer(alarmValue, callback, arg);
+      }
+      else
+      {
+#if USING_ESP32_C3_TIMERINTERRUPT
+        ISR_SERVO_LOGERROR(F("Error. Timer must be 0-1"));
+#else
+        ISR_SERVO_LOGERROR(F("Error. Timer must be 0-3"));
+#endif
+
+        return false;
+      }
+    }
+
+    // Current counter value, in timer ticks. Only to be called from the timer callback
+    inline uint64_t IRAM_ATTR getCounterInISR()
+    {
+      return timer_group_get_counter_value_in_isr(_timerGroup, _timerIndex);
+    }
+
+    // Next alarm at absolute counter value alarmValue. Only to be called from the timer callback,
+    // the timer driver re-enables the alarm on return when the value has changed
+    inline void IRAM_ATTR setAlarmInISR(const uint64_t& alarmValue)
     {
-      return setFrequency( (float) ( 1000000.0f / interval), callback);
+      timer_group_set_alarm_value_in_isr(_timerGroup, _timerIndex, alarmValue);
     }
 
     void detachInterrupt()
@@ -11,7 +11,7 @@
   Therefore, their executions are not blocked by bad-behaving functions / tasks.
   This important feature is absolutely necessary for mission-critical tasks.
 
-  Version: 1.4.0
+  Version: 1.6.0
 
   Version Modified By   Date      Comments
   ------- -----------  ---------- -----------
@@ -24,6 +24,7 @@
   1.3.0   K Hoang      08/05/2022 Fix issue with ESP32 core v2.0.1+
   1.3.1   K Hoang      16/06/2022 Add support to new Adafruit boards
   1.4.0   K Hoang      03/08/2022 Suppress errors and warnings for new ESP32 core
+  1.6.0   K Hoang      17/10/2026 Edge-scheduled ISR, lock-free frames, motion, LEDC / RMT backends. See changelog.md
  *****************************************************************************************************************************/
 
 #pragma once
@@ -11,7 +11,7 @@
   Therefore, their executions are not blocked by bad-behaving functions / tasks.
   This important feature is absolutely necessary for mission-critical tasks.
 
-  Version: 1.4.0
+  Version: 1.6.0
 
   Version Modified By   Date      Comments
   ------- -----------  ---------- -----------
@@ -24,6 +24,7 @@
   1.3.0   K Hoang      08/05/2022 Fix issue with ESP32 core v2.0.1+
   1.3.1   K Hoang      16/06/2022 Add support to new Adafruit boards
   1.4.0   K Hoang      03/08/2022 Suppress errors and warnings for new ESP32 core
+  1.6.0   K Hoang      17/10/2026 Edge-scheduled ISR, lock-free frames, motion, LEDC / RMT backends. See changelog.md
  *****************************************************************************************************************************/
 
 #pragma once
@@ -48,13 +49,13 @@
 #endif
 
 #if !defined(ESP32_ISR_SERVO_VERSION)
-  #define ESP32_ISR_SERVO_VERSION             "ESP32_ISR_Servo v1.4.0"
+  #define ESP32_ISR_SERVO_VERSION             "ESP32_ISR_Servo v1.6.0"
   
   #define ESP32_ISR_SERVO_VERSION_MAJOR       1
-  #define ESP32_ISR_SERVO_VERSION_MINOR       4
+  #define ESP32_ISR_SERVO_VERSION_MINOR       6
   #define ESP32_ISR_SERVO_VERSION_PATCH       0
 
-  #define ESP32_ISR_SERVO_VERSION_INT         1004000
+  #define ESP32_ISR_SERVO_VERSION_INT         1006000
   
 #endif
 
@@ -76,11 +77,69 @@
 
 #include "ESP32_ISR_Servo_Debug.h"
 
+// true  => timer alarm is re-programmed to the next pending pulse edge, ISR fires only (numServos + 1) times per frame
+// false => legacy fixed tick, ISR fires every TIMER_INTERVAL_MICRO (12uS) and checks all servos each time
+#ifndef ISR_SERVO_USING_EDGE_SCHEDULING
+  #define ISR_SERVO_USING_EDGE_SCHEDULING       true
+#endif
+
 #include "ESP32FastTimerInterrupt.hpp"
 
+#include "driver/ledc.h"
+#include "driver/rmt.h"
+
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "soc/gpio_reg.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// true => every edge applied by the ISR is logged with the CPU cycle count into a ring buffer, see readTrace()
+#ifndef ISR_SERVO_TRACE
+  #define ISR_SERVO_TRACE               false
+#endif
+
+// true => the ISR counts its runs, CPU cycles, latency and late runs, see getStats(). A few CPU cycles per ISR run
+#ifndef ISR_SERVO_STATS
+  #define ISR_SERVO_STATS               true
+#endif
+
+// true => a servo times out when its setters stop being called, see ESP32_ISR_Servo::setFailsafe(). The ISR checks
+// the timeouts at each frame start and applies the failsafe by itself, so a hung control task can't leave a servo
+// loaded. One more edge per ISR pulse in the frames, and one more mask per edge: about 4.5KB more RAM with 16 servos
+#ifndef ISR_SERVO_FAILSAFE
+  #define ISR_SERVO_FAILSAFE            false
+#endif
+
+#if (ISR_SERVO_TRACE || ISR_SERVO_STATS)
+  #include "hal/cpu_hal.h"
+#endif
+
+#if ISR_SERVO_TRACE
+  // Number of entries of the trace ring buffer, must be a power of 2
+  #ifndef ISR_SERVO_TRACE_SIZE
+    #define ISR_SERVO_TRACE_SIZE        256
+  #endif
+
+  #if (ISR_SERVO_TRACE_SIZE & (ISR_SERVO_TRACE_SIZE - 1))
+    #error ISR_SERVO_TRACE_SIZE must be a power of 2
+  #endif
+#endif
+
 #define ESP32_MAX_PIN           39
 #define ESP32_WRONG_PIN         255
 
+// Pins 0-31 are driven through GPIO_OUT_W1TS/W1TC, pins 32+ (if any) through GPIO_OUT1_W1TS/W1TC
+#if (SOC_GPIO_PIN_COUNT > 32)
+  #define ISR_SERVO_GPIO_BANKS    2
+#else
+  #define ISR_SERVO_GPIO_BANKS    1
+#endif
+
+#define ISR_SERVO_GPIO_BANK(pin)    ( (pin) >> 5 )
+#define ISR_SERVO_GPIO_MASK(pin)    ( 1UL << ( (pin) & 31 ) )
+
 // From Servo.h - Copyright (c) 2009 Michael Margolis.  All right reserved.
 
 #define MIN_PULSE_WIDTH         544       // the shortest pulse sent to a servo  
@@ -88,35 +147,270 @@
 #define DEFAULT_PULSE_WIDTH     1500      // default pulse width when servo is attached
 #define REFRESH_INTERVAL        20000     // minumim time to refresh servos in microseconds 
 
+// Segments of the calibration table of each servo, equally spaced over 0 - 180 degrees, see
+// ESP32_ISR_Servo::setCalibration(). 8 => a point every 22.5 degrees, 48 bytes of RAM per servo
+#ifndef ISR_SERVO_CAL_SEGMENTS
+  #define ISR_SERVO_CAL_SEGMENTS        8
+#endif
+
+#if (18000 % ISR_SERVO_CAL_SEGMENTS)
+  #error ISR_SERVO_CAL_SEGMENTS must divide 18000, the positions are in centidegrees
+#endif
+
+// Centidegrees per calibration segment
+#define ISR_SERVO_CAL_STEP        ( 18000 / ISR_SERVO_CAL_SEGMENTS )
+
+// Rising edges spread across the frame by default, see ESP32_ISR_Servo::setStaggered()
+#ifndef ISR_SERVO_STAGGERED_PULSES
+  #define ISR_SERVO_STAGGERED_PULSES    false
+#endif
+
+// Phase offset between consecutive servo slots when staggered, in microsecs.
+// (20000 - 2400) / 16 = 1100 => at most 3 outputs HIGH at the same time
+#ifndef ISR_SERVO_STAGGER_STEP
+  #define ISR_SERVO_STAGGER_STEP        ( (REFRESH_INTERVAL - MAX_PULSE_WIDTH) / 16 )
+#endif
+
+// Most pulses per REFRESH_INTERVAL of a servo refreshed faster, see the refreshInterval of ESP32_ISR_Servo::setupServo().
+// 8 => every 2500uS (400Hz)
+#ifndef ISR_SERVO_MAX_PULSES_PER_FRAME
+  #define ISR_SERVO_MAX_PULSES_PER_FRAME  8
+#endif
+
+// Pulses per REFRESH_INTERVAL of all faster ISR servos of an engine, beyond one per servo. Each costs 2 edges in
+// the 3 frames of the engine. 10 => e.g. 2 servos at 300Hz, 6 pulses each. 0 => every servo at REFRESH_INTERVAL
+#ifndef ISR_SERVO_EXTRA_PULSES
+  #define ISR_SERVO_EXTRA_PULSES          10
+#endif
+
+// Number of servos driven by the LEDC peripheral instead of the ISR, with no CPU load per pulse.
+// 0 => all servos are driven by the ISR, as before. See ESP32_ISR_Servo::setupServo()
+#ifndef ISR_SERVO_LEDC_CHANNELS
+  #define ISR_SERVO_LEDC_CHANNELS       0
+#endif
+
+// First LEDC channel (low speed mode) used for servos. Channels below are left to the sketch
+#ifndef ISR_SERVO_LEDC_FIRST_CHANNEL
+  #define ISR_SERVO_LEDC_FIRST_CHANNEL  0
+#endif
+
+#if (ISR_SERVO_LEDC_FIRST_CHANNEL + ISR_SERVO_LEDC_CHANNELS > SOC_LEDC_CHANNEL_NUM)
+  #error ISR_SERVO_LEDC_FIRST_CHANNEL + ISR_SERVO_LEDC_CHANNELS exceeds the number of LEDC channels of this board
+#endif
+
+// LEDC timer (low speed mode), shared by all servo channels at 1 / REFRESH_INTERVAL
+#ifndef ISR_SERVO_LEDC_TIMER
+  #define ISR_SERVO_LEDC_TIMER          LEDC_TIMER_3
+#endif
+
+// LEDC duty resolution in bits. 16 bits => 0.3uS, 14 bits => 1.2uS in 20ms
+#ifndef ISR_SERVO_LEDC_RESOLUTION
+  #if (SOC_LEDC_TIMER_BIT_WIDE_NUM < 16)
+    #define ISR_SERVO_LEDC_RESOLUTION   SOC_LEDC_TIMER_BIT_WIDE_NUM
+  #else
+    #define ISR_SERVO_LEDC_RESOLUTION   16
+  #endif
+#endif
+
+// Number of RMT TX channels servos can be explicitly bound to with ISR_SERVO_BACKEND_RMT. Each pulse is looped
+// by the RMT hardware with 0.1uS resolution, immune to ISR latency. Never used by ISR_SERVO_BACKEND_AUTO
+#ifndef ISR_SERVO_RMT_CHANNELS
+  #define ISR_SERVO_RMT_CHANNELS        0
+#endif
+
+// First RMT channel used for servos. Channels below are left to the sketch
+#ifndef ISR_SERVO_RMT_FIRST_CHANNEL
+  #define ISR_SERVO_RMT_FIRST_CHANNEL   0
+#endif
+
+#if (ISR_SERVO_RMT_FIRST_CHANNEL + ISR_SERVO_RMT_CHANNELS > SOC_RMT_TX_CANDIDATES_PER_GROUP)
+  #error ISR_SERVO_RMT_FIRST_CHANNEL + ISR_SERVO_RMT_CHANNELS exceeds the number of RMT TX channels of this board
+#endif
+
+// RMT clock divider from the 80MHz APB clock. 8 => 0.1uS
+#ifndef ISR_SERVO_RMT_CLK_DIV
+  #define ISR_SERVO_RMT_CLK_DIV         8
+#endif
+
+#define ISR_SERVO_RMT_TICKS_PER_US    ( APB_CLK_FREQ / ISR_SERVO_RMT_CLK_DIV / 1000000UL )
+
+// Duration of the first RMT item of the frame, the only one holding the pulse: HIGH pulseWidth then LOW.
+// Must be longer than the max pulse width, and fit in the 15-bit item duration
+#define ISR_SERVO_RMT_HEAD_US         3000
+
+#define ISR_SERVO_NO_CHANNEL          255
+
+// Hardware timer clock divider. With edge scheduling, the pulse edges are programmed directly in timer ticks,
+// so a smaller divider gives finer pulse resolution without raising the ISR rate. 8 => 0.1uS with 80MHz APB clock
+#ifndef ISR_SERVO_TIMER_DIVIDER
+  #if ISR_SERVO_USING_EDGE_SCHEDULING
+    #define ISR_SERVO_TIMER_DIVIDER   8
+  #else
+    #define ISR_SERVO_TIMER_DIVIDER   TIMER_DIVIDER
+  #endif
+#endif
+
+// Hardware timer ticks per microsecond
+#define ISR_SERVO_TICKS_PER_US  ( TIMER_BASE_CLK / ISR_SERVO_TIMER_DIVIDER / 1000000UL )
+
+// Conversions between microsecs / nanosecs and the servo count, the unit the ISR works with:
+// timer ticks with edge scheduling, TIMER_INTERVAL_MICRO ticks otherwise
+#if ISR_SERVO_USING_EDGE_SCHEDULING
+  #define ISR_SERVO_US_TO_COUNT(us)       ( (uint32_t) (us) * ISR_SERVO_TICKS_PER_US )
+  #define ISR_SERVO_NS_TO_COUNT(ns)       ( (uint32_t) (ns) * ISR_SERVO_TICKS_PER_US / 1000 )
+  #define ISR_SERVO_COUNT_TO_US(count)    ( ( (count) + ISR_SERVO_TICKS_PER_US / 2 ) / ISR_SERVO_TICKS_PER_US )
+  #define ISR_SERVO_COUNT_TO_NS(count)    ( (count) * 1000 / ISR_SERVO_TICKS_PER_US )
+#else
+  #define ISR_SERVO_US_TO_COUNT(us)       ( (uint32_t) (us) / TIMER_INTERVAL_MICRO )
+  #define ISR_SERVO_NS_TO_COUNT(ns)       ( (uint32_t) (ns) / (TIMER_INTERVAL_MICRO * 1000) )
+  #define ISR_SERVO_COUNT_TO_US(count)    ( (count) * TIMER_INTERVAL_MICRO )
+  #define ISR_SERVO_COUNT_TO_NS(count)    ( (count) * TIMER_INTERVAL_MICRO * 1000 )
+#endif
+
+// Edges closer than this to the current counter are handled by busy-waiting inside the ISR instead of re-arming
+// the alarm, which could otherwise be programmed to a value the free-running counter has already passed
+#ifndef ISR_SERVO_EDGE_GUARD_US
+  #define ISR_SERVO_EDGE_GUARD_US   4
+#endif
+
+// ISR runs starting more than this after their timer alarm are counted as late by getStats(), in microsecs
+#ifndef ISR_SERVO_LATE_US
+  #define ISR_SERVO_LATE_US         2
+#endif
+
+// Timer (0-3) of the default ESP32_ISR_Servos engine, and of engines constructed without timer number
+#ifndef DEFAULT_ESP32_TIMER_NO
+  #define DEFAULT_ESP32_TIMER_NO        3
+#endif
+
 extern void IRAM_ATTR ESP32_ISR_Servo_Handler();
 
-class ESP32_ISR_Servo
+// Hardware resources shared by all servo engines, whatever their number of servos
+class ESP32_ISR_ServoShared
 {
+  protected:
+    // Bitmask of the LEDC channels in use by all engines, bit 0 = ISR_SERVO_LEDC_FIRST_CHANNEL
+    static uint32_t   ledcChannels;
+    static bool       ledcTimerOK;
+
+    // Bitmask of the RMT channels in use by all engines, bit 0 = ISR_SERVO_RMT_FIRST_CHANNEL
+    static uint32_t   rmtChannels;
+
+    // Bitmask of the hardware timers driven by an engine
+    static uint32_t   usedTimers;
+
+    // Normalized position (0-1) along motion profile at normalized time u (0-1)
+    static float profileAt(const uint8_t& profile, const float& u);
+
+    // Shortest duration in secs of a move of distance degrees with profile, within maxSpeed (degrees / sec)
+    // and maxAccel (degrees / sec^2), 0 => no limit
+    static float minDuration(const uint8_t& profile, const float& distance, const uint16_t& maxSpeed,
+                             const uint16_t& maxAccel);
+};
+
+// Which engine drives the pulses of a servo, see ESP32_ISR_Servo::setupServo()
+typedef enum
+{
+  ISR_SERVO_BACKEND_AUTO  = 0,      // LEDC if a channel is still free, ISR otherwise
+  ISR_SERVO_BACKEND_ISR   = 1,      // Software pulses from the timer ISR
+  ISR_SERVO_BACKEND_LEDC  = 2,      // Hardware pulses from a LEDC channel
+  ISR_SERVO_BACKEND_RMT   = 3       // Hardware pulses looped by a RMT channel
+} isr_servo_backend_t;
+
+// Position over time of ESP32_ISR_Servo::moveTo()
+typedef enum
+{
+  ISR_SERVO_PROFILE_LINEAR      = 0,      // Constant speed, speed steps at both ends
+  ISR_SERVO_PROFILE_TRAPEZOIDAL = 1,      // Constant acceleration over the first and last quarter, constant speed between
+  ISR_SERVO_PROFILE_SCURVE      = 2       // Minimum jerk (quintic) curve, acceleration ramps up and down smoothly
+} isr_servo_profile_t;
+
+// What the ISR does with a servo not commanded within its timeout, see ESP32_ISR_Servo::setFailsafe()
+typedef enum
+{
+  ISR_SERVO_FAILSAFE_OFF    = 0,      // No timeout
+  ISR_SERVO_FAILSAFE_HOLD   = 1,      // Keep the last pulse width, only reported by isFailsafe()
+  ISR_SERVO_FAILSAFE_PARK   = 2,      // Pulse width of setFailsafe(), such as a safe rest position
+  ISR_SERVO_FAILSAFE_STOP   = 3       // No more pulses, like disable(): most servos then go limp
+} isr_servo_failsafe_t;
+
+// Keyframe sequence of ESP32_ISR_Servo::playSequence(), a byte array in flash (const), RAM or PSRAM. Each keyframe is
+// its time in ms from the start of the sequence (32-bit, little endian), the mask of its servos (32-bit, little endian,
+// bit n = servoIndex n, 0-31), then one position in degrees (0-180) per servo of the mask, lowest servoIndex first. Times
+// must not decrease. Write keyframes as
+//   const uint8_t wave[] = { ISR_SERVO_KEYFRAME(0, 0x03), 90, 90, ISR_SERVO_KEYFRAME(500, 0x01), 180, ... };
+#define ISR_SERVO_KEYFRAME(timeMs, servoMask)                                                                 \
+  (uint8_t) (timeMs), (uint8_t) ((timeMs) >> 8), (uint8_t) ((timeMs) >> 16), (uint8_t) ((uint32_t) (timeMs) >> 24), \
+  (uint8_t) (servoMask), (uint8_t) ((servoMask) >> 8), (uint8_t) ((servoMask) >> 16), (uint8_t) ((uint32_t) (servoMask) >> 24)
+
+// Bytes of a keyframe before its positions
+#define ISR_SERVO_KEYFRAME_HEADER     8
+
+// One edge applied by the ISR: all pins switching together, with the CPU cycle count (32-bit, wrapping) just before
+typedef struct
+{
+  uint32_t  cycles;
+  uint32_t  setMask[ISR_SERVO_GPIO_BANKS];        // pins driven HIGH, bit n of entry b = GPIO (32 * b + n)
+  uint32_t  clearMask[ISR_SERVO_GPIO_BANKS];      // pins driven LOW
+} isr_servo_trace_t;
+
+// Counters of the ISR of an engine since ESP32_ISR_Servo::resetStats(), see getStats()
+typedef struct
+{
+  uint32_t  isrCalls;
+  uint32_t  isrCyclesMin;                         // CPU cycles of the shortest, average and longest ISR run
+  uint32_t  isrCyclesAvg;
+  uint32_t  isrCyclesMax;
+  uint64_t  isrCyclesTotal;                       // ISR CPU load = isrCyclesTotal / (CPU MHz * elapsed microsecs)
+  uint32_t  latencyMaxNs;                         // longest delay from the timer alarm to the ISR run
+  uint32_t  lateRuns;                             // ISR runs more than ISR_SERVO_LATE_US after their alarm
+  uint32_t  missedTicks;                          // tick mode: TIMER_INTERVAL_MICRO ticks lost, 0 with edge scheduling
+  uint32_t  frames;                               // frames started
+} isr_servo_stats_t;
+
+// The setters never lock nor wait for the ISR, their changes are published to the ISR at the next frame boundary.
+// They are not re-entrant: call them from one task at a time (single producer).
+// Servos on LEDC or RMT channels are updated through their driver, taking effect at the next period.
+// Each engine drives up to MAX_SERVOS servos from its own hardware timer and ISR. Besides the default ESP32_ISR_Servos,
+// more engines can be declared on other timers, such as ESP32_ISR_Servo armServos(1), to split more servos across
+// timers and cores. The LEDC and RMT channels are shared by all engines.
+// ESP32_ISR_ServoT<N> is an engine sized for N servos (1-127): RAM, frame size and all loops over the servos scale
+// with N, known at compile time. ESP32_ISR_Servo is the 16 servos engine
+template <uint8_t N>
+class ESP32_ISR_ServoT : protected ESP32_ISR_ServoShared
+{
+    static_assert( (N > 0) && (N <= 127), "ESP32_ISR_ServoT: number of servos must be 1-127, servoIndex is int8_t");
 
   public:
     // maximum number of servos
-    const static int MAX_SERVOS = 16;
+    const static int MAX_SERVOS = N;
 
-    // constructor
-    ESP32_ISR_Servo();
+    // constructor, engine on timer timerNo (0-3)
+    ESP32_ISR_ServoT(const uint8_t& timerNo = DEFAULT_ESP32_TIMER_NO);
 
     // destructor
-    ~ESP32_ISR_Servo()
+    ~ESP32_ISR_ServoT()
     {
       if (ESP32_ITimer)
       {
         ESP32_ITimer->detachInterrupt();
         delete ESP32_ITimer;
+
+        usedTimers &= ~(1UL << _timerNo);
       }
+
+      // Give back the shared LEDC and RMT channels to the other engines
+      for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+        detachChannel(servoIndex);
     }
 
     void IRAM_ATTR run();
 
     // useTimer select which timer (0-3) of ESP32 to use for Servos
-    //Return true if timerN0 in range
+    //Return true if timerN0 in range, false also once the timer is started by the first setupServo()
     bool useTimer(const uint8_t& timerNo)
     {
-      if (timerNo < MAX_ESP32_NUM_TIMERS)
+      if ( (timerNo < MAX_ESP32_NUM_TIMERS) && (numServos < 0) )
       {
         _timerNo = timerNo;
         return true;
@@ -125,7 +419,26 @@ class ESP32_ISR_Servo
     }
 
     // Bind servo to the timer and pin, return servoIndex
-    int8_t setupServo(const uint8_t& pin, const uint16_t& min = MIN_PULSE_WIDTH, const uint16_t& max = MAX_PULSE_WIDTH);
+    // The first call starts the timer, with its interrupt allocated on the core running it. To run the ISR of an engine
+    // on the other core, call its first setupServo() from a task pinned to that core. returns -1 while the timer is
+    // used by another engine or fails to start
+    // With ISR_SERVO_BACKEND_AUTO, the first ISR_SERVO_LEDC_CHANNELS servos are driven by LEDC, the others by the ISR.
+    // ISR_SERVO_BACKEND_RMT binds the servo to one of the ISR_SERVO_RMT_CHANNELS RMT channels, or fails
+    // refreshInterval in microsecs, for digital servos accepting faster pulses: rounded up to REFRESH_INTERVAL / n,
+    // n up to ISR_SERVO_MAX_PULSES_PER_FRAME, e.g. 3000 => 3333uS (300Hz). Such ISR servos split the frame into
+    // n subframes, and the setters then take effect at the next subframe instead of the next frame. All n of an
+    // engine must divide the largest one, within ISR_SERVO_EXTRA_PULSES, and every max pulse width must be shorter
+    // than a subframe. Not available on LEDC channels, nor on RMT channels below ISR_SERVO_RMT_HEAD_US
+    int8_t setupServo(const uint8_t& pin, const uint16_t& min = MIN_PULSE_WIDTH, const uint16_t& max = MAX_PULSE_WIDTH,
+                      const isr_servo_backend_t& backend = ISR_SERVO_BACKEND_AUTO,
+                      const uint16_t& refreshInterval = REFRESH_INTERVAL);
+
+    // returns the period of the pulses of the servo in microsecs, or 0 on wrong servoIndex
+    uint16_t getRefreshInterval(const uint8_t& servoIndex);
+
+    // returns the engine driving the servo, ISR_SERVO_BACKEND_ISR, ISR_SERVO_BACKEND_LEDC or ISR_SERVO_BACKEND_RMT,
+    // or ISR_SERVO_BACKEND_AUTO on wrong servoIndex
+    isr_servo_backend_t getBackend(const uint8_t& servoIndex);
 
     // setPosition will set servo to position in degrees
     // by using PWM, turn HIGH 'duration' microseconds within REFRESH_INTERVAL (20000us)
@@ -135,6 +448,26 @@ class ESP32_ISR_Servo
     // returns last position in degrees if success, or -1 on wrong servoIndex
     int getPosition(const uint8_t& servoIndex);
 
+    // Same as setPosition(), but in centidegrees (0 - 18000)
+    bool setPositionCd(const uint8_t& servoIndex, const uint16_t& centidegrees);
+
+    // returns last position in centidegrees if success, or -1 on wrong servoIndex
+    int32_t getPositionCd(const uint8_t& servoIndex);
+
+    // Calibrate a nonlinear servo: numPoints pulse widths in microsecs, at equally spaced positions from 0 to 180 degrees,
+    // e.g. 5 => at 0, 45, 90, 135 and 180 degrees. Resampled into ISR_SERVO_CAL_SEGMENTS linear segments, exactly if
+    // numPoints - 1 divides ISR_SERVO_CAL_SEGMENTS. Widths must be monotonic, and become the new min and max of
+    // setPulseWidth(). Applied right away at the current position. returns false on wrong servoIndex or widths, or a
+    // max pulse width too long for the frame
+    bool setCalibration(const uint8_t& servoIndex, const uint16_t* pulseWidths, const uint8_t& numPoints);
+
+    // Offset in microsecs added to every pulse width of the calibration, applied right away at the current position.
+    // returns false on wrong servoIndex, or a max pulse width too long for the frame
+    bool setTrim(const uint8_t& servoIndex, const int16_t& trimUs);
+
+    // true => position 0 at the 180 degrees pulse width of the calibration and the other way round, applied right away
+    bool setReversed(const uint8_t& servoIndex, const bool& reversed);
+
     // setPulseWidth will set servo PWM Pulse Width in microseconds, correcponding to certain position in degrees
     // by using PWM, turn HIGH 'pulseWidth' microseconds within REFRESH_INTERVAL (20000us)
     // min and max for each individual servo are enforced
@@ -144,6 +477,21 @@ class ESP32_ISR_Servo
     // returns pulseWidth in microsecs (within min/max range) if success, or 0 on wrong servoIndex
     unsigned int getPulseWidth(const uint8_t& servoIndex);
 
+    // Same as setPulseWidth(), but in nanosecs. With edge scheduling, resolution is one timer tick
+    // (1000 / ISR_SERVO_TICKS_PER_US nanosecs), otherwise TIMER_INTERVAL_MICRO
+    bool setPulseWidthNs(const uint8_t& servoIndex, uint32_t& pulseWidthNs);
+
+    // returns pulseWidth in nanosecs, at the resolution actually programmed, or 0 on wrong servoIndex
+    uint32_t getPulseWidthNs(const uint8_t& servoIndex);
+
+    // Set all servos of mask (bit n = servoIndex n, 0-31) in one call, with one position in degrees per servo of the
+    // mask, lowest servoIndex first. Checked once and published together like beginUpdate() / commitUpdate().
+    // returns false, with no servo changed, if any servo of the mask isn't set up and enabled
+    bool setPositions(const uint16_t* positions, const uint32_t& mask);
+
+    // Same as setPositions(), with pulse widths in microsecs, each kept within the min and max of its servo
+    bool setPulseWidths(const uint16_t* pulseWidths, const uint32_t& mask);
+
     // destroy the specified servo
     void deleteServo(const uint8_t& servoIndex);
 
@@ -169,6 +517,142 @@ class ESP32_ISR_Servo
     // returns the number of used servos
     int8_t getNumServos();
 
+    // Group the changes of any setters called until commitUpdate(), which publishes them together.
+    // All ISR servos then switch in the same frame. Servos on LEDC / RMT channels are updated right after,
+    // each taking effect at its own next period
+    void beginUpdate();
+    void commitUpdate();
+
+    // returns true between beginUpdate() and commitUpdate()
+    bool isUpdating()
+    {
+      return grouping;
+    }
+
+    // Move servo to position in degrees, in durationMs along profile. Stretched as needed to stay within the limits
+    // of setMotionLimits(). The position is updated once per frame by updateMotion(), and any other setter of the
+    // servo cancels the move. returns true on success or false on wrong servoIndex
+    bool moveTo(const uint8_t& servoIndex, const uint16_t& position, const uint32_t& durationMs,
+                const isr_servo_profile_t& profile = ISR_SERVO_PROFILE_TRAPEZOIDAL);
+
+    // Move all count servos of servoIndexes to their positions, all starting and arriving in the same frames.
+    // The duration is stretched to the slowest servo within its limits. returns false on any wrong servoIndex
+    bool moveGroupTo(const uint8_t* servoIndexes, const uint16_t* positions, const uint8_t& count,
+                     const uint32_t& durationMs, const isr_servo_profile_t& profile = ISR_SERVO_PROFILE_TRAPEZOIDAL);
+
+    // Max speed in degrees / sec and max acceleration in degrees / sec^2 of moveTo(), 0 => no limit
+    bool setMotionLimits(const uint8_t& servoIndex, const uint16_t& maxSpeed, const uint16_t& maxAccel = 0);
+
+    // returns true while servo is moving
+    bool isMoving(const uint8_t& servoIndex);
+
+    // Stop servo at its current position
+    void stopMotion(const uint8_t& servoIndex);
+
+    // Advance all moves to the next frame, at most once per frame. Call it more often than every REFRESH_INTERVAL,
+    // e.g. in loop(): the positions follow the frame counter of the ISR, so a late call skips steps, never time.
+    // returns true while any servo is moving
+    bool updateMotion();
+
+    // Play length bytes of keyframes, see ISR_SERVO_KEYFRAME(). The servos of a keyframe move to it along profile from
+    // the time of the previous keyframe, the others hold their position. Stepped by updateMotion() like moveTo(), but
+    // never stretched by setMotionLimits(). speedPercent scales time, 200 => twice as fast. loop => start over after
+    // the last keyframe, the first keyframe then taking its own time from it. sequence must stay valid while playing.
+    // returns false on an empty sequence
+    bool playSequence(const uint8_t* sequence, const uint32_t& length, const bool& loop = false,
+                      const uint16_t& speedPercent = 100, const isr_servo_profile_t& profile = ISR_SERVO_PROFILE_LINEAR);
+
+    // Stop the sequence, its servos stop at their current position
+    void stopSequence();
+
+    // Speed of the sequence in percent, from the next keyframe on
+    void setSequenceSpeed(const uint16_t& speedPercent);
+
+    // returns true while a sequence is playing
+    bool isPlaying()
+    {
+      return playing;
+    }
+
+    // true => each servo slot gets a fixed phase offset of (servoIndex * ISR_SERVO_STAGGER_STEP) uS in the frame,
+    // instead of all servos turning HIGH together at the start of frame. This limits how many outputs are HIGH
+    // at the same time (supply inrush current) and how many edges the ISR handles at once
+    void setStaggered(const bool& stagger);
+
+    bool isStaggered()
+    {
+      return staggered;
+    }
+
+    // Notify task (vTaskNotifyGiveFromISR) at the start of each frame, NULL => stop. A control task waiting with
+    // waitFrame() wakes aligned to the frame, and its setters land in the next frame, 20ms later at most
+    void setFrameNotify(TaskHandle_t task = xTaskGetCurrentTaskHandle())
+    {
+      __atomic_store_n(&frameTask, task, __ATOMIC_RELEASE);
+    }
+
+    // Wait, from the task of setFrameNotify(), for the start of the next frame, up to timeout ticks.
+    // returns the number of frames started since the last call, more than 1 if frames were missed, 0 on timeout
+    uint32_t waitFrame(const TickType_t& timeout = portMAX_DELAY)
+    {
+      return ulTaskNotifyTake(pdTRUE, timeout);
+    }
+
+#if ISR_SERVO_TRACE
+    // Copy up to maxEntries of the oldest trace entries, and remove them from the ring buffer.
+    // returns the number of entries copied. Call from one task at a time (single reader)
+    uint16_t readTrace(isr_servo_trace_t* entries, const uint16_t& maxEntries);
+
+    // returns the number of trace entries lost because the ring buffer was full, since the last call
+    uint32_t getTraceDropped()
+    {
+      return __atomic_exchange_n(&traceDropped, 0, __ATOMIC_RELAXED);
+    }
+
+    // returns the longest ISR run in CPU cycles, since the last call
+    uint32_t getTraceMaxIsrCycles()
+    {
+      return __atomic_exchange_n(&traceMaxIsrCycles, 0, __ATOMIC_RELAXED);
+    }
+#endif
+
+    // Stop the pulses of servoIndex idleMs after its last setter (setPosition(), setPulseWidth(), moveTo() steps...),
+    // from the next frame start, to save the holding current of servos with nothing to hold. The ISR skips the pulses
+    // of idle servos, and the next setter resumes them. 0 => never idle, the default. Only for servos driven by the ISR.
+    // returns false on wrong servoIndex or a servo on a LEDC / RMT channel
+    bool setAutoIdle(const uint8_t& servoIndex, const uint32_t& idleMs);
+
+    // returns true while servoIndex is idle
+    bool isIdle(const uint8_t& servoIndex);
+
+#if ISR_SERVO_FAILSAFE
+    // Time out servoIndex when none of its setters (setPosition(), setPulseWidth(), moveTo() steps...) nor feed() is
+    // called for timeoutMs, then apply action from the next frame start, within one frame. The next setter or feed()
+    // restores the commanded pulses. Pulse width of ISR_SERVO_FAILSAFE_PARK within min and max.
+    // timeoutMs 0 or ISR_SERVO_FAILSAFE_OFF => no timeout. Only for servos driven by the ISR: the LEDC and RMT channels
+    // can't be changed from the ISR. returns false on wrong servoIndex or a servo on a LEDC / RMT channel
+    bool setFailsafe(const uint8_t& servoIndex, const uint32_t& timeoutMs, const uint8_t& action = ISR_SERVO_FAILSAFE_STOP,
+                     const uint16_t& pulseWidth = DEFAULT_PULSE_WIDTH);
+
+    // Restart the timeout of servoIndex, or of all servos, without changing their position
+    void feed(const uint8_t& servoIndex);
+    void feedAll();
+
+    // returns true while servoIndex is timed out, from the start of the frame it timed out in
+    bool isFailsafe(const uint8_t& servoIndex);
+#endif
+
+#if ISR_SERVO_STATS
+    // Copy the ISR counters into stats, all from the same ISR run even while the ISR runs on the other core
+    void getStats(isr_servo_stats_t& stats);
+
+    // Restart the ISR counters, at the next ISR run
+    void resetStats()
+    {
+      __atomic_store_n(&statsReset, true, __ATOMIC_RELEASE);
+    }
+#endif
+
     // returns the number of available servos
     int8_t getNumAvailableServos() 
     {
@@ -184,19 +668,67 @@ class ESP32_ISR_Servo
     // Use 12 microsecs timer now, just fine enough to control Servo, normally requiring pulse width (PWM) 500-2000us in 20ms.
 #define TIMER_INTERVAL_MICRO        12
 
-    void init()
+    // Start the timer and reset all servos. returns false, leaving the engine uninitialized, if the timer is used
+    // by another engine or fails to start
+    bool init()
     {
+      // Only one engine per timer, the new callback would replace the previous one
+      if (usedTimers & (1UL << _timerNo))
+      {
+        ISR_SERVO_LOGERROR1("Timer already used by another engine, timer =", _timerNo);
+
+        return false;
+      }
 
-      ESP32_ITimer = new ESP32FastTimer(_timerNo);
+      ESP32_ITimer = new ESP32FastTimer(_timerNo, ISR_SERVO_TIMER_DIVIDER);
+
+      // All frames empty
+      memset((void*) frames, 0, sizeof(frames));
+      activeFrame   = 0;
+      readyFrame    = 1;
+      backFrame     = 2;
+      edgeCursor    = 0;
+      subframe      = 1;
+
+#if ISR_SERVO_TRACE
+      traceHead         = 0;
+      traceTail         = 0;
+      traceDropped      = 0;
+      traceMaxIsrCycles = 0;
+#endif
 
+#if ISR_SERVO_STATS
+      statsSeq          = 0;
+      statsReset        = true;
+  #if !ISR_SERVO_USING_EDGE_SCHEDULING
+      statsTickCycles   = TIMER_INTERVAL_MICRO * getCpuFrequencyMhz();
+  #endif
+#endif
+
+#if ISR_SERVO_USING_EDGE_SCHEDULING
+      // First alarm starts the first frame
+      frameStartAt  = 0;
+      nextEdgeAt    = ISR_SERVO_US_TO_COUNT(REFRESH_INTERVAL);
+
+      if (ESP32_ITimer->attachInterruptAlarm(nextEdgeAt, timerHandler, this))
+#else
       // Interval in microsecs
-      if ( ESP32_ITimer && ESP32_ITimer->attachInterruptInterval(TIMER_INTERVAL_MICRO, (timer_callback) ESP32_ISR_Servo_Handler ) )
+      if (ESP32_ITimer->attachInterruptInterval(TIMER_INTERVAL_MICRO, timerHandler, this))
+#endif
       {
         ISR_SERVO_LOGERROR("Starting  ITimer OK");
+
+        usedTimers |= (1UL << _timerNo);
       }
       else
       {
-        ISR_SERVO_LOGERROR("Fail setup ESP32_ITimer");      }
+        ISR_SERVO_LOGERROR("Fail setup ESP32_ITimer");
+
+        delete ESP32_ITimer;
+        ESP32_ITimer = NULL;
+
+        return false;
+      }
 
       for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
       {
@@ -205,30 +737,139 @@ class ESP32_ISR_Servo
         servo[servoIndex].enabled  = false;
         // Intentional bad pin
         servo[servoIndex].pin      = ESP32_WRONG_PIN;
+        servo[servoIndex].backend  = ISR_SERVO_BACKEND_ISR;
+        servo[servoIndex].channel  = ISR_SERVO_NO_CHANNEL;
+        servo[servoIndex].pulses   = 1;
       }
 
-      numServos   = 0;
+      numServos     = 0;
+      numActive     = 0;
+      numSubframes  = 1;
+
+      memset((void*) motion, 0, sizeof(motion));
+      numMoving   = 0;
+
+      memset((void*) idle, 0, sizeof(idle));
+      memset(mutePins, 0, sizeof(mutePins));
+      masking = false;
+
+#if ISR_SERVO_FAILSAFE
+      memset((void*) failsafe, 0, sizeof(failsafe));
+      memset(parkPins, 0, sizeof(parkPins));
+#endif
+      frameCount  = 0;
+      motionFrame = 0;
+      playing     = false;
 
       // Init timerCount
       timerCount  = 1;
 
-      timerMux = portMUX_INITIALIZER_UNLOCKED;
+      return true;
     }
 
+    // Timer callback of all engines, arg is the engine
+    static bool IRAM_ATTR timerHandler(void* arg);
+
     // find the first available slot
     int8_t findFirstFreeSlot();
 
+    // Drive HIGH all pins in mask (one entry per GPIO bank), with one W1TS register write per bank
+    static inline void IRAM_ATTR setPins(const uint32_t* mask)
+    {
+      if (mask[0])
+        REG_WRITE(GPIO_OUT_W1TS_REG, mask[0]);
+
+#if (ISR_SERVO_GPIO_BANKS > 1)
+      if (mask[1])
+        REG_WRITE(GPIO_OUT1_W1TS_REG, mask[1]);
+#endif
+    }
+
+    // Drive LOW all pins in mask (one entry per GPIO bank), with one W1TC register write per bank
+    static inline void IRAM_ATTR clearPins(const uint32_t* mask)
+    {
+      if (mask[0])
+        REG_WRITE(GPIO_OUT_W1TC_REG, mask[0]);
+
+#if (ISR_SERVO_GPIO_BANKS > 1)
+      if (mask[1])
+        REG_WRITE(GPIO_OUT1_W1TC_REG, mask[1]);
+#endif
+    }
+
+    // Largest fields first, 16 bytes with no padding on ESP32 (was 20)
     typedef struct
     {
-      uint8_t       pin;                  // pin servo connected to
-      unsigned long count;                // In microsecs
-      uint16_t      position;             // In degrees
-      bool          enabled;              // true if enabled
+      unsigned long count;                // In ISR_SERVO_US_TO_COUNT() units
+      uint16_t      position;             // In centidegrees
       uint16_t      min;
       uint16_t      max;
+      uint8_t       pin;                  // pin servo connected to
+      bool          enabled;              // true if enabled
+      uint8_t       backend;              // ISR_SERVO_BACKEND_ISR, ISR_SERVO_BACKEND_LEDC or ISR_SERVO_BACKEND_RMT
+      uint8_t       channel;              // LEDC or RMT channel, or ISR_SERVO_NO_CHANNEL if driven by the ISR
+      uint8_t       pulses;               // per REFRESH_INTERVAL, 1 => every REFRESH_INTERVAL
     } servo_t;
 
-    volatile servo_t servo[MAX_SERVOS];
+    // Only accessed by the setters, the ISR works from the frames built by updateFrame()
+    servo_t servo[MAX_SERVOS];
+
+    // Calibration of a servo: count at each of the ISR_SERVO_CAL_SEGMENTS + 1 positions, from 0 to 180 degrees, not
+    // reversed and without trim. min and max of servo_t are those of the table, plus trim
+    typedef struct
+    {
+      unsigned long count[ISR_SERVO_CAL_SEGMENTS + 1];
+      int32_t       trimCount;            // In ISR_SERVO_US_TO_COUNT() units
+      int16_t       trim;                 // In microsecs
+      uint16_t      min;                  // Of the table, in microsecs
+      uint16_t      max;
+      bool          reversed;
+    } calibration_t;
+
+    calibration_t calibration[MAX_SERVOS];
+
+    // Position in centidegrees to count, O(1) from the table with constant divisors only. And back, for setPulseWidth()
+    unsigned long getCount(const uint8_t& servoIndex, const uint16_t& centidegrees);
+    uint16_t      getPositionAt(const uint8_t& servoIndex, const unsigned long& count);
+
+    bool          setLimits(const uint8_t& servoIndex, const int16_t& trim);
+    void          updateCount(const uint8_t& servoIndex);
+
+    bool          isValidMask(const uint32_t& mask);
+
+    // Idle timeout of a servo, deadline written by the setters
+    typedef struct
+    {
+      uint32_t      frames;               // 0 => never idle
+      uint32_t      deadline;             // frameCount the servo is idle from
+    } idle_t;
+
+    idle_t idle[MAX_SERVOS];
+
+#if ISR_SERVO_FAILSAFE
+    // Timeout of a servo. deadline is written by the setters, tripped by the ISR
+    typedef struct
+    {
+      uint32_t      timeoutFrames;
+      uint32_t      deadline;             // frameCount the servo times out at
+      unsigned long parkCount;            // In ISR_SERVO_US_TO_COUNT() units
+      uint8_t       action;               // isr_servo_failsafe_t
+      bool          tripped;
+    } failsafe_t;
+
+    failsafe_t failsafe[MAX_SERVOS];
+#endif
+
+    // Dense index of the enabled servos driven by the ISR, the only ones updateFrame() walks.
+    // Rebuilt by updateActive() when a servo is set up, deleted, enabled or disabled, not on position changes
+    uint8_t activeServo[MAX_SERVOS];
+    uint8_t numActive;
+
+    // Subframes of the active servos, the largest pulses per REFRESH_INTERVAL
+    uint8_t numSubframes;
+
+    void updateActive();
+    bool fitsFrame(const uint8_t& servoIndex, const uint8_t& pulses, const uint16_t& max);
 
     // actual number of servos in use (-1 means uninitialized)
     volatile int8_t numServos;
@@ -238,13 +879,431 @@ class ESP32_ISR_Servo
     // For example, servo1 uses pulse width 1000us => turned ON when timerCount = 1, turned OFF when timerCount = 1000 / TIMER_INTERVAL_MICRO = 100
     volatile unsigned long timerCount;
 
-    // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
-    portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED;
+    // Rising and falling edges of all servos switching at the same time, in count units from the start of the frame
+    typedef struct
+    {
+      uint32_t      at;
+      uint32_t      setMask[ISR_SERVO_GPIO_BANKS];
+      uint32_t      clearMask[ISR_SERVO_GPIO_BANKS];
+#if ISR_SERVO_FAILSAFE
+      uint32_t      parkMask[ISR_SERVO_GPIO_BANKS];     // pins of parked servos falling here instead
+#endif
+    } edge_t;
+
+    // Rising and falling edges of all pulses, and the subframe boundaries, if any servo can be faster.
+    // Plus the failsafe falling edges of the parked pulses
+    static const uint16_t FRAME_EDGES = (ISR_SERVO_FAILSAFE ? 3 : 2) * (MAX_SERVOS + ISR_SERVO_EXTRA_PULSES)
+                                        + (ISR_SERVO_EXTRA_PULSES ? ISR_SERVO_MAX_PULSES_PER_FRAME : 0);
+
+    // Pins of a servo with an idle or failsafe timeout, and its failsafe action when the frame was built
+    typedef struct
+    {
+      uint32_t      mask;
+      uint8_t       bank;
+      uint8_t       servoIndex;
+      uint8_t       action;               // isr_servo_failsafe_t
+      bool          idle;                 // Has an idle timeout
+    } frame_timeout_t;
+
+    // Everything the ISR needs for one frame, precomputed by updateFrame() in task context.
+    // No pulse spans a subframe boundary, so the ISR can also switch to a newer frame there
+    typedef struct
+    {
+      uint16_t      numEdges;
+      uint8_t       numSubframes;
+      uint8_t       numTimeouts;
+      uint16_t      subframeEdge[ISR_SERVO_MAX_PULSES_PER_FRAME];     // edge at the very start of each subframe
+      edge_t        edges[FRAME_EDGES];                               // sorted by time
+      frame_timeout_t timeouts[MAX_SERVOS];
+    } frame_t;
+
+    // Pins of the idle or stopped servos in frames[activeFrame], no edge at all, and of the parked servos, the failsafe
+    // falling edge instead.
+    // Only accessed by the ISR
+    uint32_t          mutePins[ISR_SERVO_GPIO_BANKS];
+    bool              masking;              // Any pin in mutePins or parkPins
+#if ISR_SERVO_FAILSAFE
+    uint32_t          parkPins[ISR_SERVO_GPIO_BANKS];
+#endif
+
+    // Check the idle and failsafe timeouts of the servos of frames[activeFrame], at the start of each frame or after
+    // a frame switch. One compare per timeout
+    inline void IRAM_ATTR updateTimeouts()
+    {
+      const frame_t& frame = frames[activeFrame];
+
+      memset(mutePins, 0, sizeof(mutePins));
+      masking = false;
+
+#if ISR_SERVO_FAILSAFE
+      memset(parkPins, 0, sizeof(parkPins));
+#endif
+
+      for (uint8_t index = 0; index < frame.numTimeouts; index++)
+      {
+        const frame_timeout_t& entry = frame.timeouts[index];
+
+        if ( entry.idle &&
+             ( (int32_t) (frameCount - __atomic_load_n(&idle[entry.servoIndex].deadline, __ATOMIC_ACQUIRE)) >= 0 ) )
+        {
+          mutePins[entry.bank] |= entry.mask;
+          masking = true;
+        }
+
+#if ISR_SERVO_FAILSAFE
+        if (entry.action == ISR_SERVO_FAILSAFE_OFF)
+          continue;
+
+        failsafe_t& timeout = failsafe[entry.servoIndex];
+
+        const bool tripped = ( (int32_t) (frameCount - __atomic_load_n(&timeout.deadline, __ATOMIC_ACQUIRE)) >= 0 );
+
+        __atomic_store_n(&timeout.tripped, tripped, __ATOMIC_RELAXED);
+
+        if (!tripped)
+          continue;
+
+        if (entry.action == ISR_SERVO_FAILSAFE_STOP)
+        {
+          mutePins[entry.bank] |= entry.mask;
+          masking = true;
+        }
+        else if (entry.action == ISR_SERVO_FAILSAFE_PARK)
+        {
+          parkPins[entry.bank] |= entry.mask;
+          masking = true;
+        }
+#endif
+      }
+    }
+
+    // Pins edge switches in the current frame: none for the idle or stopped servos, already LOW since mutePins only
+    // changes at frame or subframe boundaries, and the falling edges of the parked servos at their failsafe pulse
+    // width. returns false if none
+    inline bool IRAM_ATTR getEdgeMasks(const edge_t& edge, uint32_t* setMask, uint32_t* clearMask)
+    {
+      uint32_t any = 0;
+
+      for (uint8_t bank = 0; bank < ISR_SERVO_GPIO_BANKS; bank++)
+      {
+        setMask[bank]   = edge.setMask[bank] & ~mutePins[bank];
+#if ISR_SERVO_FAILSAFE
+        clearMask[bank] = ( (edge.clearMask[bank] & ~parkPins[bank]) | (edge.parkMask[bank] & parkPins[bank]) )
+                          & ~mutePins[bank];
+#else
+        clearMask[bank] = edge.clearMask[bank] & ~mutePins[bank];
+#endif
+        any            |= setMask[bank] | clearMask[bank];
+      }
+
+      return (any != 0);
+    }
+
+    // Apply all rising and falling edges due at the same time, and log them
+    inline void IRAM_ATTR applyEdge(const edge_t& edge)
+    {
+      if (!masking)
+      {
+        clearPins(edge.clearMask);
+        setPins(edge.setMask);
+        traceEdge(edge);
+
+        return;
+      }
+
+      edge_t applied;
+
+      applied.at = edge.at;
+      getEdgeMasks(edge, applied.setMask, applied.clearMask);
+
+      clearPins(applied.clearMask);
+      setPins(applied.setMask);
+      traceEdge(applied);
+    }
+
+    // Move edgeCursor past the edges left with no pin to switch, such as those of idle servos, up to the next
+    // subframe boundary, so that the ISR isn't even called for them
+    inline void IRAM_ATTR skipMaskedEdges()
+    {
+      if (!masking)
+        return;
+
+      const frame_t& frame = frames[activeFrame];
+
+      uint32_t setMask[ISR_SERVO_GPIO_BANKS];
+      uint32_t clearMask[ISR_SERVO_GPIO_BANKS];
+
+      while ( (edgeCursor < frame.numEdges) && !getEdgeMasks(frame.edges[edgeCursor], setMask, clearMask)
+              && ( (subframe >= frame.numSubframes) || (edgeCursor != frame.subframeEdge[subframe]) ) )
+        edgeCursor++;
+    }
+
+#if ISR_SERVO_TRACE
+    // Single producer (ISR) / single consumer (readTrace()) ring buffer, indexes only ever increase
+    isr_servo_trace_t trace[ISR_SERVO_TRACE_SIZE];
+    uint32_t          traceHead;            // Only written by the ISR
+    uint32_t          traceTail;            // Only written by readTrace()
+    uint32_t          traceDropped;
+    uint32_t          traceMaxIsrCycles;
+#endif
+
+    // Log edge into the trace ring buffer, if enabled
+    inline void IRAM_ATTR traceEdge(const edge_t& edge)
+    {
+#if ISR_SERVO_TRACE
+      if (traceHead - __atomic_load_n(&traceTail, __ATOMIC_ACQUIRE) < ISR_SERVO_TRACE_SIZE)
+      {
+        isr_servo_trace_t& entry = trace[traceHead & (ISR_SERVO_TRACE_SIZE - 1)];
+
+        entry.cycles = cpu_hal_get_cycle_count();
+        memcpy(entry.setMask,   edge.setMask,   sizeof(entry.setMask));
+        memcpy(entry.clearMask, edge.clearMask, sizeof(entry.clearMask));
+
+        __atomic_store_n(&traceHead, traceHead + 1, __ATOMIC_RELEASE);
+      }
+      else
+        __atomic_fetch_add(&traceDropped, 1, __ATOMIC_RELAXED);
+#else
+      (void) edge;
+#endif
+    }
+
+#if ISR_SERVO_TRACE
+    inline void IRAM_ATTR traceIsr(const uint32_t& startCycles)
+    {
+      uint32_t isrCycles = cpu_hal_get_cycle_count() - startCycles;
+
+      if (isrCycles > traceMaxIsrCycles)
+        traceMaxIsrCycles = isrCycles;
+    }
+#endif
+
+#if ISR_SERVO_STATS
+    // Only written by the ISR. statsSeq is odd while the ISR updates isrStats (seqlock), see getStats()
+    isr_servo_stats_t isrStats;
+    uint32_t          statsSeq;
+    uint32_t          statsFrameBase;       // frameCount at the last reset
+    bool              statsReset;           // Set by resetStats(), cleared by the ISR
+  #if !ISR_SERVO_USING_EDGE_SCHEDULING
+    uint32_t          statsTickCycles;      // CPU cycles per tick
+    uint32_t          statsLastCycles;      // CPU cycle count at the start of the previous run
+  #endif
+
+    // Count an ISR run started at startCycles, latency timer ticks after its alarm
+    inline void IRAM_ATTR updateStats(const uint32_t& startCycles, const uint32_t& latency)
+    {
+      const uint32_t cycles = cpu_hal_get_cycle_count() - startCycles;
+
+      __atomic_store_n(&statsSeq, statsSeq + 1, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+
+      if (__atomic_load_n(&statsReset, __ATOMIC_ACQUIRE))
+      {
+        memset(&isrStats, 0, sizeof(isrStats));
+        isrStats.isrCyclesMin = UINT32_MAX;
+        statsFrameBase        = frameCount;
+
+        __atomic_store_n(&statsReset, false, __ATOMIC_RELAXED);
+      }
+
+      isrStats.isrCalls++;
+      isrStats.isrCyclesTotal += cycles;
+
+      if (cycles < isrStats.isrCyclesMin)
+        isrStats.isrCyclesMin = cycles;
+
+      if (cycles > isrStats.isrCyclesMax)
+        isrStats.isrCyclesMax = cycles;
+
+  #if ISR_SERVO_USING_EDGE_SCHEDULING
+      const uint32_t latencyNs = latency * 1000 / ISR_SERVO_TICKS_PER_US;
+  #else
+      // The tick timer reloads by itself: latency is how much later than one tick after the previous run this one starts
+      const uint32_t period     = startCycles - statsLastCycles;
+      const uint32_t latencyNs  = ( (isrStats.isrCalls > 1) && (period > statsTickCycles) ) ?
+                                  (uint64_t) (period - statsTickCycles) * 1000 * TIMER_INTERVAL_MICRO / statsTickCycles : 0;
+
+      if ( (isrStats.isrCalls > 1) && (period >= statsTickCycles + statsTickCycles / 2) )
+        isrStats.missedTicks += (period + statsTickCycles / 2) / statsTickCycles - 1;
+
+      statsLastCycles = startCycles;
+      (void) latency;
+  #endif
+
+      if (latencyNs > isrStats.latencyMaxNs)
+        isrStats.latencyMaxNs = latencyNs;
+
+      if (latencyNs > ISR_SERVO_LATE_US * 1000)
+        isrStats.lateRuns++;
+
+      isrStats.frames = frameCount - statsFrameBase;
+
+      __atomic_store_n(&statsSeq, statsSeq + 1, __ATOMIC_RELEASE);
+    }
+#endif
+
+    // Lock-free triple buffer between the setters (single producer) and the ISR (single consumer):
+    // the ISR only reads frames[activeFrame], setters rebuild frames[backFrame], then atomically exchange it with
+    // readyFrame. At the next frame boundary, the ISR exchanges activeFrame with readyFrame if a new one was published.
+    // A frame never changes between a rise and its fall, and several updates within a frame coalesce into the last one
+#define ISR_SERVO_FRAME_NEW     0x80
+
+    frame_t           frames[3];
+    uint8_t           activeFrame;          // Only accessed by the ISR
+    uint8_t           backFrame;            // Only accessed by the setters
+    uint8_t           readyFrame;           // Index | ISR_SERVO_FRAME_NEW. Only accessed with __atomic builtins
+
+    uint16_t          edgeCursor;           // next edge to handle in frames[activeFrame]. Only accessed by the ISR
+    uint8_t           subframe;             // next subframe boundary in frames[activeFrame]. Only accessed by the ISR
+
+    // At the start of each subframe, switch to a newer frame if one was published, from the same point in time.
+    // Called before applying each edge
+    inline void IRAM_ATTR checkSubframe()
+    {
+      const frame_t& frame = frames[activeFrame];
+
+      if ( (subframe >= frame.numSubframes) || (edgeCursor != frame.subframeEdge[subframe]) )
+        return;
+
+      if (__atomic_load_n(&readyFrame, __ATOMIC_ACQUIRE) & ISR_SERVO_FRAME_NEW)
+      {
+        // The current frame goes back to the setters at the exchange, and the new one is only ours after it:
+        // nothing of either is read across the exchange
+        const uint32_t at         = frame.edges[edgeCursor].at;
+        const uint8_t  subframes  = frame.numSubframes;
+        const uint8_t  current    = activeFrame;
+
+        activeFrame = __atomic_exchange_n(&readyFrame, current, __ATOMIC_ACQ_REL) & ~ISR_SERVO_FRAME_NEW;
+
+        const frame_t& next = frames[activeFrame];
+
+        if (next.numSubframes == subframes)
+          edgeCursor = next.subframeEdge[subframe];
+        else
+        {
+          uint8_t expected = current;
+
+          // Other subframes: hand the new frame back for the next frame start, unless the setters already took the
+          // current one to publish yet another frame. Then resume the new one at the same time, up to the next frame
+          if (__atomic_compare_exchange_n(&readyFrame, &expected, activeFrame | ISR_SERVO_FRAME_NEW, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+          {
+            activeFrame = current;
+          }
+          else
+          {
+            updateTimeouts();
+
+            for (edgeCursor = 0; (edgeCursor < next.numEdges) && (next.edges[edgeCursor].at < at); edgeCursor++);
+
+            subframe = next.numSubframes;
+
+            return;
+          }
+        }
+
+        updateTimeouts();
+      }
+
+      subframe++;
+    }
+
+#if ISR_SERVO_USING_EDGE_SCHEDULING
+    // Absolute counter values of the free-running timer
+    uint64_t  frameStartAt;
+    uint64_t  nextEdgeAt;
+#endif
+
+    // Rising edges spread across the frame, see setStaggered()
+    bool              staggered;
+
+    // Number of frames started by the ISR, the time base of moveTo()
+    uint32_t          frameCount;
+
+    // Task notified at the start of each frame, see setFrameNotify()
+    TaskHandle_t      frameTask;
+    BaseType_t        frameWoken;           // frameTask woken by the current ISR run, yield at its end
+
+    // One move of moveTo(), from fromPosition at frame startFrame to toPosition numFrames later, in centidegrees
+    typedef struct
+    {
+      uint32_t      startFrame;
+      uint32_t      numFrames;
+      uint16_t      fromPosition;
+      uint16_t      toPosition;
+      uint16_t      maxSpeed;             // degrees / sec, 0 => no limit
+      uint16_t      maxAccel;             // degrees / sec^2, 0 => no limit
+      uint8_t       profile;
+      bool          moving;
+    } motion_t;
+
+    motion_t          motion[MAX_SERVOS];
+    uint8_t           numMoving;
+    uint32_t          motionFrame;          // frameCount of the last updateMotion() step
+
+    void cancelMotion(const uint8_t& servoIndex);
+
+    uint32_t getMoveMs(const uint8_t& servoIndex, const uint16_t& position, const uint32_t& durationMs,
+                       const uint8_t& profile);
+    uint32_t getMoveFrames(const uint32_t& durationMs);
+    void     startMove(const uint8_t& servoIndex, const uint16_t& position, const uint32_t& numFrames,
+                       const uint8_t& profile, const uint32_t& startFrame);
+    void     stepMotion(const uint32_t& frame);
+
+    // Between beginUpdate() and commitUpdate(): frame and LEDC / RMT channels to update at commit
+    bool              grouping;
+    bool              groupFrame;
+    bool              groupChannels[MAX_SERVOS];
+
+    // Keyframe player of playSequence(): the moves to the keyframe at keyOffset start at frame keyFrame,
+    // when the servos reach the previous keyframe at time keyTimeMs
+    bool              playing;
+    bool              playLoop;
+    uint8_t           playProfile;
+    uint16_t          playSpeed;            // percent
+    const uint8_t*    sequence;
+    uint32_t          sequenceLength;
+    uint32_t          keyOffset;
+    uint32_t          keyTimeMs;
+    uint32_t          keyFrame;
+    uint32_t          keyRemainder;         // of the scaled time, not yet a whole frame
+    uint32_t          loopFrame;            // keyFrame at the start of the pass, to stop a sequence with no duration
+    uint32_t          playMask;             // servos moved by the sequence
+
+    bool updateSequence(const uint32_t& frame);
+
+    void IRAM_ATTR startFrame();
+
+    uint32_t getOffset(const uint8_t& servoIndex, const uint32_t& length);
+
+    edge_t* findEdge(frame_t& frame, const uint32_t& at);
+    void    addEdge(frame_t& frame, const uint32_t& at, const uint8_t& pin, const bool& rising);
+    void updateFrame();
+
+    int8_t attachLEDC(const uint8_t& pin);
+    void   detachLEDC(const uint8_t& servoIndex);
+    void   updateLEDC(const uint8_t& servoIndex);
+
+    int8_t attachRMT(const uint8_t& pin, const uint16_t& period);
+    void   detachRMT(const uint8_t& servoIndex);
+    void   updateRMT(const uint8_t& servoIndex);
+
+    // Release the LEDC or RMT channel of servoIndex, if any
+    void   detachChannel(const uint8_t& servoIndex);
+
+    // Apply the new settings of one servo, or of all of them, to the engine driving it
+    void updateServo(const uint8_t& servoIndex);
+    void updateAll();
 
     // For ESP32 timer
     uint8_t _timerNo;
     ESP32FastTimer* ESP32_ITimer;
 };
 
+// Default engine, up to 16 servos as before. Instantiated once in ESP32_ISR_Servo_Impl.h
+typedef ESP32_ISR_ServoT<16> ESP32_ISR_Servo;
+
+extern template class ESP32_ISR_ServoT<16>;
+
 
 #endif    // ESP32_ISR_SERVO_HPP
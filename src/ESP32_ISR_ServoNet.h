@@ -0,0 +1,297 @@
+/****************************************************************************************************************************
+  ESP32_ISR_ServoNet.h
+  For ESP32 boards
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32_ISR_Servo
+  Licensed under MIT license
+
+  Optional control plane of ESP32_ISR_Servo: applies servo poses streamed from a PC in a compact binary protocol,
+  over UDP or any other packet transport. Include after ESP32_ISR_Servo.h, in the .ino with setup()
+
+  Pose packet, all fields little endian:
+    0   'I', 'S'          magic
+    2   uint8_t           protocol version, ISR_SERVO_NET_VERSION
+    3   uint8_t           flags, ISR_SERVO_NET_FLAG_*
+    4   uint32_t          sequence number, incremented by the sender for each pose
+    8   uint32_t          sender timestamp, in microsecs of the sender clock, echoed back in the ack
+    12  uint32_t          mask of the servos of the pose, bit n = servoIndex n, 0-31
+    16  uint16_t[]        one pulse width in microsecs per servo of the mask, lowest servoIndex first
+
+  Ack packet, sent back to the sender for poses with ISR_SERVO_NET_FLAG_ACK: the same 16 bytes header with
+  ISR_SERVO_NET_FLAG_REPLY set, the sequence number and timestamp of the pose, and its isr_servo_net_status_t
+  in place of the mask. The sender measures the round trip from the timestamp
+ *****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32_ISR_SERVO_NET_H
+#define ESP32_ISR_SERVO_NET_H
+
+#include "ESP32_ISR_Servo.hpp"
+
+#define ISR_SERVO_NET_VERSION         1
+
+// Bytes of a packet before its pulse widths, and of the longest pose, 32 servos
+#define ISR_SERVO_NET_HEADER          16
+#define ISR_SERVO_NET_MAX_PACKET      (ISR_SERVO_NET_HEADER + 32 * 2)
+
+// Flags of a packet
+#define ISR_SERVO_NET_FLAG_ACK        0x01        // pose: send an ack back
+#define ISR_SERVO_NET_FLAG_REPLY      0x80        // ack
+
+// UDP port of the examples and extras/host/servo_send
+#ifndef ISR_SERVO_NET_PORT
+	#define ISR_SERVO_NET_PORT          4210
+#endif
+
+// After this long without any valid pose, the next pose is accepted whatever its sequence number, so that a
+// restarted sender doesn't have its poses dropped as stale, in ms
+#ifndef ISR_SERVO_NET_RESYNC_MS
+	#define ISR_SERVO_NET_RESYNC_MS     1000
+#endif
+
+// What became of a pose packet, see ESP32_ISR_ServoNet::handlePacket()
+typedef enum
+{
+	ISR_SERVO_NET_APPLIED   = 0,        // Pulse widths set, published at the next frame
+	ISR_SERVO_NET_STALE     = 1,        // Sequence number not newer than the last applied pose, dropped
+	ISR_SERVO_NET_INVALID   = 2,        // Not a pose packet of this protocol version, or wrong length
+	ISR_SERVO_NET_REJECTED  = 3         // A servo of the mask isn't set up and enabled, nothing changed
+} isr_servo_net_status_t;
+
+// Packet counters since ESP32_ISR_ServoNet::resetStats()
+typedef struct
+{
+	uint32_t  received;
+	uint32_t  applied;
+	uint32_t  stale;
+	uint32_t  invalid;
+	uint32_t  rejected;
+	uint32_t  commits;                  // poll() calls publishing poses, at most one per frame when polled per frame
+	uint32_t  lastSeq;                  // sequence number of the last applied pose
+} isr_servo_net_stats_t;
+
+// Pose server of an engine. Packets are parsed in place from a fixed buffer, nothing is allocated.
+// Call poll() from one task, best the task of setFrameNotify() right after waitFrame(): all the poses queued
+// since the last call are applied in one update group, so the newest pulse width of each servo lands in the next
+// frame and older poses of the same frame are never output.
+// ESP32_ISR_ServoNetT<N> serves an ESP32_ISR_ServoT<N> engine, ESP32_ISR_ServoNet the 16 servos engine
+template <uint8_t N>
+class ESP32_ISR_ServoNetT
+{
+	public:
+
+		ESP32_ISR_ServoNetT(ESP32_ISR_ServoT<N>& servos) : servos(servos)
+		{
+			resetStats();
+		}
+
+		// Read all the packets pending in udp (WiFiUDP, AsyncUDP-like or any class with parsePacket(), read(),
+		// remoteIP(), remotePort(), beginPacket(), write(), endPacket()), apply the poses and ack them.
+		// returns the number of packets read
+		template <class UDP>
+		uint16_t poll(UDP& udp)
+		{
+			uint16_t  count     = 0;
+			bool      ownGroup  = false;
+			int       length;
+
+			while ( (length = udp.parsePacket()) > 0 )
+			{
+				if (count == 0)
+				{
+					ownGroup = !servos.isUpdating();
+
+					if (ownGroup)
+						servos.beginUpdate();
+				}
+
+				count++;
+
+				if (length > ISR_SERVO_NET_MAX_PACKET)
+				{
+					// Still drop it from the receive queue
+					while (udp.read(packet, sizeof(packet)) > 0);
+
+					stats.received++;
+					stats.invalid++;
+
+					continue;
+				}
+
+				length = udp.read(packet, length);
+
+				isr_servo_net_status_t status = handlePacket(packet, length);
+
+				if ( (length >= ISR_SERVO_NET_HEADER) && (status != ISR_SERVO_NET_INVALID) &&
+				     (packet[3] & ISR_SERVO_NET_FLAG_ACK) )
+				{
+					encodeAck(packet, status);
+
+					udp.beginPacket(udp.remoteIP(), udp.remotePort());
+					udp.write(packet, ISR_SERVO_NET_HEADER);
+					udp.endPacket();
+				}
+			}
+
+			if ( (count > 0) && ownGroup )
+			{
+				if (appliedSince)
+					stats.commits++;
+
+				appliedSince = false;
+
+				servos.commitUpdate();
+			}
+
+			return count;
+		}
+
+		// Apply one pose packet from any transport (ESP-NOW, Serial...). In an update group the pose is published
+		// at commitUpdate(), otherwise at the next frame
+		isr_servo_net_status_t handlePacket(const uint8_t* data, const uint16_t& length)
+		{
+			stats.received++;
+
+			if ( !data || (length < ISR_SERVO_NET_HEADER) || (data[0] != 'I') || (data[1] != 'S') ||
+			     (data[2] != ISR_SERVO_NET_VERSION) || (data[3] & ISR_SERVO_NET_FLAG_REPLY) )
+			{
+				stats.invalid++;
+
+				return ISR_SERVO_NET_INVALID;
+			}
+
+			uint32_t seq  = read32(data + 4);
+			uint32_t mask = read32(data + 12);
+
+			if (length != ISR_SERVO_NET_HEADER + 2 * __builtin_popcount(mask))
+			{
+				stats.invalid++;
+
+				return ISR_SERVO_NET_INVALID;
+			}
+
+			uint32_t now = millis();
+
+			// Wrapping compare of the sequence numbers
+			if ( synced && ((int32_t) (seq - stats.lastSeq) <= 0) && (now - lastMs < ISR_SERVO_NET_RESYNC_MS) )
+			{
+				stats.stale++;
+
+				return ISR_SERVO_NET_STALE;
+			}
+
+			uint16_t        widths[32];
+			const uint8_t*  width = data + ISR_SERVO_NET_HEADER;
+
+			for (uint8_t index = 0; width < data + length; index++, width += 2)
+				widths[index] = width[0] | (width[1] << 8);
+
+			if (!servos.setPulseWidths(widths, mask))
+			{
+				stats.rejected++;
+
+				return ISR_SERVO_NET_REJECTED;
+			}
+
+			synced        = true;
+			lastMs        = now;
+			appliedSince  = true;
+
+			stats.lastSeq = seq;
+			stats.applied++;
+
+			return ISR_SERVO_NET_APPLIED;
+		}
+
+		// Write a pose packet of the pulse widths (one per servo of mask, lowest servoIndex first) into packet,
+		// ISR_SERVO_NET_HEADER + 2 * servos of mask bytes. returns its length
+		static uint16_t encodePose(uint8_t* packet, const uint32_t& seq, const uint32_t& timeUs, const uint32_t& mask,
+		                           const uint16_t* pulseWidths, const uint8_t& flags = 0)
+		{
+			uint8_t numServos = __builtin_popcount(mask);
+
+			packet[0] = 'I';
+			packet[1] = 'S';
+			packet[2] = ISR_SERVO_NET_VERSION;
+			packet[3] = flags;
+
+			write32(packet + 4, seq);
+			write32(packet + 8, timeUs);
+			write32(packet + 12, mask);
+
+			for (uint8_t index = 0; index < numServos; index++)
+			{
+				packet[ISR_SERVO_NET_HEADER + 2 * index]      = (uint8_t) pulseWidths[index];
+				packet[ISR_SERVO_NET_HEADER + 2 * index + 1]  = (uint8_t) (pulseWidths[index] >> 8);
+			}
+
+			return ISR_SERVO_NET_HEADER + 2 * numServos;
+		}
+
+		// Turn the header of a pose packet into its ack
+		static void encodeAck(uint8_t* packet, const isr_servo_net_status_t& status)
+		{
+			packet[3] = (packet[3] & ~ISR_SERVO_NET_FLAG_ACK) | ISR_SERVO_NET_FLAG_REPLY;
+
+			write32(packet + 12, status);
+		}
+
+		// Parse an ack, returns false if packet isn't one. seq and timeUs are those of the pose
+		static bool decodeAck(const uint8_t* packet, const uint16_t& length, uint32_t& seq, uint32_t& timeUs,
+		                      isr_servo_net_status_t& status)
+		{
+			if ( (length != ISR_SERVO_NET_HEADER) || (packet[0] != 'I') || (packet[1] != 'S') ||
+			     (packet[2] != ISR_SERVO_NET_VERSION) || !(packet[3] & ISR_SERVO_NET_FLAG_REPLY) )
+				return false;
+
+			seq     = read32(packet + 4);
+			timeUs  = read32(packet + 8);
+			status  = (isr_servo_net_status_t) read32(packet + 12);
+
+			return true;
+		}
+
+		void getStats(isr_servo_net_stats_t& stats)
+		{
+			stats = this->stats;
+		}
+
+		// Restart the counters. The next pose is accepted whatever its sequence number
+		void resetStats()
+		{
+			memset(&stats, 0, sizeof(stats));
+
+			synced        = false;
+			appliedSince  = false;
+		}
+
+	private:
+
+		static uint32_t read32(const uint8_t* data)
+		{
+			return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+		}
+
+		static void write32(uint8_t* data, const uint32_t& value)
+		{
+			data[0] = (uint8_t) value;
+			data[1] = (uint8_t) (value >> 8);
+			data[2] = (uint8_t) (value >> 16);
+			data[3] = (uint8_t) (value >> 24);
+		}
+
+		ESP32_ISR_ServoT<N>&    servos;
+
+		uint8_t                 packet[ISR_SERVO_NET_MAX_PACKET];
+
+		isr_servo_net_stats_t   stats;
+		bool                    synced;             // false => accept the next pose whatever its sequence number
+		bool                    appliedSince;       // a pose was applied since the last commit
+		uint32_t                lastMs;             // millis() of the last applied pose
+};
+
+typedef ESP32_ISR_ServoNetT<16> ESP32_ISR_ServoNet;
+
+#endif    // ESP32_ISR_SERVO_NET_H
@@ -11,7 +11,7 @@
   Therefore, their executions are not blocked by bad-behaving functions / tasks.
   This important feature is absolutely necessary for mission-critical tasks.
 
-  Version: 1.4.0
+  Version: 1.6.0
 
   Version Modified By   Date      Comments
   ------- -----------  ---------- -----------
@@ -24,6 +24,7 @@
   1.3.0   K Hoang      08/05/2022 Fix issue with ESP32 core v2.0.1+
   1.3.1   K Hoang      16/06/2022 Add support to new Adafruit boards
   1.4.0   K Hoang      03/08/2022 Suppress errors and warnings for new ESP32 core
+  1.6.0   K Hoang      17/10/2026 Edge-scheduled ISR, lock-free frames, motion, LEDC / RMT backends. See changelog.md
  *****************************************************************************************************************************/
 
 #pragma once
@@ -57,6 +58,225 @@ const char ISR_SERVO_SP[]    = " ";
 
 //////////////////////////////////////////////////////
 
+// true => the ISR_SERVO_LOG* macros only store a binary record (the string pointers and values, not the text) into a
+// lock-free ring buffer, safe from the ISR and both cores. The text is printed later by ISR_SERVO_LOG_DRAIN(), from loop()
+// or a low priority task, so logging never blocks on Serial. String arguments must be literals or F() strings
+#ifndef ISR_SERVO_LOG_DEFERRED
+	#define ISR_SERVO_LOG_DEFERRED        false
+#endif
+
+#if ISR_SERVO_LOG_DEFERRED
+
+#include <type_traits>
+
+// Number of records of the log ring buffer, must be a power of 2
+#ifndef ISR_SERVO_LOG_SIZE
+	#define ISR_SERVO_LOG_SIZE            64
+#endif
+
+#if (ISR_SERVO_LOG_SIZE & (ISR_SERVO_LOG_SIZE - 1))
+	#error ISR_SERVO_LOG_SIZE must be a power of 2
+#endif
+
+// Up to ISR_SERVO_LOG*3(x,y,z,w)
+#define ISR_SERVO_LOG_ARGS                4
+
+typedef enum
+{
+	ISR_SERVO_LOG_NONE    = 0,
+	ISR_SERVO_LOG_STR     = 1,
+	ISR_SERVO_LOG_INT     = 2,
+	ISR_SERVO_LOG_UINT    = 3,
+	ISR_SERVO_LOG_FLOAT   = 4
+} isr_servo_log_type_t;
+
+typedef struct
+{
+	uint8_t       type;                 // isr_servo_log_type_t
+	union
+	{
+		const char* str;
+		int32_t     i;
+		uint32_t    u;
+		float       f;
+	};
+} isr_servo_log_arg_t;
+
+typedef struct
+{
+	uint32_t            seq;            // Ring position + 1, once the record is complete
+	uint32_t            timeUs;         // micros() when logged
+	bool                line;           // false => ISR_SERVO_LOG*0(x), no mark nor new line
+	isr_servo_log_arg_t args[ISR_SERVO_LOG_ARGS];
+} isr_servo_log_t;
+
+class ESP32_ISR_ServoLog
+{
+	public:
+
+		// Reserve the next record with a CAS on head, so that the ISR and tasks on both cores can log concurrently.
+		// The record is dropped if the ring buffer is full
+		template <typename... Args>
+		static inline void IRAM_ATTR write(const bool& line, const Args&... args)
+		{
+			static_assert(sizeof...(Args) <= ISR_SERVO_LOG_ARGS, "Too many ISR_SERVO_LOG arguments");
+
+			uint32_t pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+
+			do
+			{
+				if (pos - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= ISR_SERVO_LOG_SIZE)
+				{
+					__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+
+					return;
+				}
+			} while (!__atomic_compare_exchange_n(&head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+			isr_servo_log_t& record = ring[pos & (ISR_SERVO_LOG_SIZE - 1)];
+			uint8_t          index  = 0;
+
+			record.timeUs = micros();
+			record.line   = line;
+
+			int expand[] = { 0, (record.args[index++] = arg(args), 0)... };
+			(void) expand;
+
+			while (index < ISR_SERVO_LOG_ARGS)
+				record.args[index++].type = ISR_SERVO_LOG_NONE;
+
+			// Publish to drain()
+			__atomic_store_n(&record.seq, pos + 1, __ATOMIC_RELEASE);
+		}
+
+		// Print up to maxRecords of the oldest records to out, the same text as with ISR_SERVO_LOG_DEFERRED false,
+		// plus the micros() of the log after the mark. Only one task may drain at a time.
+		// Returns the number of records printed. Stops at a record still being written by another core
+		template <class Output>
+		static uint16_t drain(Output& out, const uint16_t& maxRecords = ISR_SERVO_LOG_SIZE)
+		{
+			uint32_t pos    = tail;
+			uint16_t count  = 0;
+
+			while (count < maxRecords)
+			{
+				isr_servo_log_t& slot = ring[pos & (ISR_SERVO_LOG_SIZE - 1)];
+
+				if (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) != pos + 1)
+					break;
+
+				// Release the slot before the slow printing
+				isr_servo_log_t record = slot;
+
+				__atomic_store_n(&tail, ++pos, __ATOMIC_RELEASE);
+
+				if (record.line)
+				{
+					out.print(ISR_SERVO_MARK);
+					out.print("@");
+					out.print(record.timeUs);
+					out.print(ISR_SERVO_SP);
+				}
+
+				for (uint8_t index = 0; (index < ISR_SERVO_LOG_ARGS) && (record.args[index].type != ISR_SERVO_LOG_NONE); index++)
+				{
+					const isr_servo_log_arg_t& value = record.args[index];
+
+					if (index > 0)
+						out.print(ISR_SERVO_SP);
+
+					if (value.type == ISR_SERVO_LOG_STR)
+						out.print(value.str);
+					else if (value.type == ISR_SERVO_LOG_INT)
+						out.print(value.i);
+					else if (value.type == ISR_SERVO_LOG_UINT)
+						out.print(value.u);
+					else
+						out.print(value.f);
+				}
+
+				if (record.line)
+					out.println();
+
+				count++;
+			}
+
+			return count;
+		}
+
+		// returns the number of records lost because the ring buffer was full, since the last call
+		static uint32_t getDropped()
+		{
+			return __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+		}
+
+	private:
+
+		static isr_servo_log_t  ring[ISR_SERVO_LOG_SIZE];
+		static uint32_t         head;       // Next position to reserve
+		static uint32_t         tail;       // Only written by drain()
+		static uint32_t         dropped;
+
+		static inline isr_servo_log_arg_t IRAM_ATTR arg(const char* value)
+		{
+			isr_servo_log_arg_t result;
+
+			result.type = ISR_SERVO_LOG_STR;
+			result.str  = value;
+
+			return result;
+		}
+
+		static inline isr_servo_log_arg_t IRAM_ATTR arg(const __FlashStringHelper* value)
+		{
+			return arg(reinterpret_cast<const char*>(value));
+		}
+
+		template <typename T>
+		static inline isr_servo_log_arg_t IRAM_ATTR arg(const T& value)
+		{
+			isr_servo_log_arg_t result;
+
+			if (std::is_floating_point<T>::value)
+			{
+				result.type = ISR_SERVO_LOG_FLOAT;
+				result.f    = (float) value;
+			}
+			else if (std::is_signed<T>::value)
+			{
+				result.type = ISR_SERVO_LOG_INT;
+				result.i    = (int32_t) value;
+			}
+			else
+			{
+				result.type = ISR_SERVO_LOG_UINT;
+				result.u    = (uint32_t) value;
+			}
+
+			return result;
+		}
+};
+
+// Print the pending log records, from loop() or a low priority task
+#define ISR_SERVO_LOG_DRAIN()         ESP32_ISR_ServoLog::drain(ISR_SERVO_DEBUG_OUTPUT)
+
+#define ISR_SERVO_LOGERROR(x)         if(ISR_SERVO_DEBUG>0) { ESP32_ISR_ServoLog::write(true, x); }
+#define ISR_SERVO_LOGERROR0(x)        if(ISR_SERVO_DEBUG>0) { ESP32_ISR_ServoLog::write(false, x); }
+#define ISR_SERVO_LOGERROR1(x,y)      if(ISR_SERVO_DEBUG>0) { ESP32_ISR_ServoLog::write(true, x, y); }
+#define ISR_SERVO_LOGERROR2(x,y,z)    if(ISR_SERVO_DEBUG>0) { ESP32_ISR_ServoLog::write(true, x, y, z); }
+#define ISR_SERVO_LOGERROR3(x,y,z,w)  if(ISR_SERVO_DEBUG>0) { ESP32_ISR_ServoLog::write(true, x, y, z, w); }
+
+#define ISR_SERVO_LOGDEBUG(x)         if(ISR_SERVO_DEBUG>1) { ESP32_ISR_ServoLog::write(true, x); }
+#define ISR_SERVO_LOGDEBUG0(x)        if(ISR_SERVO_DEBUG>1) { ESP32_ISR_ServoLog::write(false, x); }
+#define ISR_SERVO_LOGDEBUG1(x,y)      if(ISR_SERVO_DEBUG>1) { ESP32_ISR_ServoLog::write(true, x, y); }
+#define ISR_SERVO_LOGDEBUG2(x,y,z)    if(ISR_SERVO_DEBUG>1) { ESP32_ISR_ServoLog::write(true, x, y, z); }
+#define ISR_SERVO_LOGDEBUG3(x,y,z,w)  if(ISR_SERVO_DEBUG>1) { ESP32_ISR_ServoLog::write(true, x, y, z, w); }
+
+#else     // ISR_SERVO_LOG_DEFERRED
+
+// Nothing to drain, the ISR_SERVO_LOG* macros print immediately
+#define ISR_SERVO_LOG_DRAIN()         (0)
+
 #define ISR_SERVO_LOGERROR(x)         if(ISR_SERVO_DEBUG>0) { ISR_SERVO_PRINT_MARK; ISR_SERVO_PRINTLN(x); }
 #define ISR_SERVO_LOGERROR0(x)        if(ISR_SERVO_DEBUG>0) { ISR_SERVO_PRINT(x); }
 #define ISR_SERVO_LOGERROR1(x,y)      if(ISR_SERVO_DEBUG>0) { ISR_SERVO_PRINT_MARK; ISR_SERVO_PRINT(x); ISR_SERVO_PRINT_SP; ISR_SERVO_PRINTLN(y); }
@@ -71,6 +291,8 @@ const char ISR_SERVO_SP[]    = " ";
 #define ISR_SERVO_LOGDEBUG2(x,y,z)    if(ISR_SERVO_DEBUG>1) { ISR_SERVO_PRINT_MARK; ISR_SERVO_PRINT(x); ISR_SERVO_PRINT_SP; ISR_SERVO_PRINT(y); ISR_SERVO_PRINT_SP; ISR_SERVO_PRINTLN(z); }
 #define ISR_SERVO_LOGDEBUG3(x,y,z,w)  if(ISR_SERVO_DEBUG>1) { ISR_SERVO_PRINT_MARK; ISR_SERVO_PRINT(x); ISR_SERVO_PRINT_SP; ISR_SERVO_PRINT(y); ISR_SERVO_PRINT_SP; ISR_SERVO_PRINT(z); ISR_SERVO_PRINT_SP; ISR_SERVO_PRINTLN(w); }
 
+#endif    // ISR_SERVO_LOG_DEFERRED
+
 //////////////////////////////////////////
 
 
@@ -11,7 +11,7 @@
   Therefore, their executions are not blocked by bad-behaving functions / tasks.
   This important feature is absolutely necessary for mission-critical tasks.
 
-  Version: 1.4.0
+  Version: 1.6.0
 
   Version Modified By   Date      Comments
   ------- -----------  ---------- -----------
@@ -24,239 +24,1571 @@
   1.3.0   K Hoang      08/05/2022 Fix issue with ESP32 core v2.0.1+
   1.3.1   K Hoang      16/06/2022 Add support to new Adafruit boards
   1.4.0   K Hoang      03/08/2022 Suppress errors and warnings for new ESP32 core
+  1.6.0   K Hoang      17/10/2026 Edge-scheduled ISR, lock-free frames, motion, LEDC / RMT backends. See changelog.md
  *****************************************************************************************************************************/
 
 #include "ESP32_ISR_Servo.h"
 #include <string.h>
+#include <math.h>
 
 #ifndef ISR_SERVO_DEBUG
 	#define ISR_SERVO_DEBUG               1
 #endif
 
-#define DEFAULT_ESP32_TIMER_NO          3
+// Shared by all engines
+uint32_t  ESP32_ISR_ServoShared::ledcChannels = 0;
+bool      ESP32_ISR_ServoShared::ledcTimerOK  = false;
+uint32_t  ESP32_ISR_ServoShared::rmtChannels  = 0;
+uint32_t  ESP32_ISR_ServoShared::usedTimers   = 0;
+
+#if ISR_SERVO_LOG_DEFERRED
+isr_servo_log_t ESP32_ISR_ServoLog::ring[ISR_SERVO_LOG_SIZE];
+uint32_t        ESP32_ISR_ServoLog::head    = 0;
+uint32_t        ESP32_ISR_ServoLog::tail    = 0;
+uint32_t        ESP32_ISR_ServoLog::dropped = 0;
+#endif
 
 static ESP32_ISR_Servo ESP32_ISR_Servos;  // create servo object to control up to 16 servos
 
+// Kept for compatibility, the engines are called through ESP32_ISR_ServoT<N>::timerHandler()
 void IRAM_ATTR ESP32_ISR_Servo_Handler()
 {
 	ESP32_ISR_Servos.run();
 }
 
-ESP32_ISR_Servo::ESP32_ISR_Servo()
-	: numServos (-1), _timerNo(DEFAULT_ESP32_TIMER_NO)
+// Normalized position along the profile, 0 at u = 0 and 1 at u = 1
+float ESP32_ISR_ServoShared::profileAt(const uint8_t& profile, const float& u)
+{
+	if (u <= 0)
+		return 0;
+
+	if (u >= 1)
+		return 1;
+
+	switch (profile)
+	{
+		case ISR_SERVO_PROFILE_TRAPEZOIDAL:
+			// Peak speed 4/3, reached at u = 1/4
+			if (u < 0.25f)
+				return (8.0f / 3) * u * u;
+			else if (u > 0.75f)
+				return 1 - (8.0f / 3) * (1 - u) * (1 - u);
+			else
+				return (1.0f / 6) + (4.0f / 3) * (u - 0.25f);
+
+		case ISR_SERVO_PROFILE_SCURVE:
+			// 10u^3 - 15u^4 + 6u^5
+			return u * u * u * (10 + u * (6 * u - 15));
+
+		default:
+			return u;
+	}
+}
+
+float ESP32_ISR_ServoShared::minDuration(const uint8_t& profile, const float& distance, const uint16_t& maxSpeed,
+                                         const uint16_t& maxAccel)
+{
+	// Peak speed and acceleration of each profile over a unit move in a unit time
+	static const float peakSpeed[] = { 1.0f, 4.0f / 3, 1.875f };
+	static const float peakAccel[] = { 0.0f, 16.0f / 3, 5.7735f };
+
+	uint8_t index     = (profile <= ISR_SERVO_PROFILE_SCURVE) ? profile : (uint8_t) ISR_SERVO_PROFILE_LINEAR;
+	float   duration  = 0;
+
+	if (maxSpeed)
+		duration = peakSpeed[index] * distance / maxSpeed;
+
+	// Linear has no acceleration phase
+	if (maxAccel && (peakAccel[index] > 0))
+	{
+		float accelDuration = sqrtf(peakAccel[index] * distance / maxAccel);
+
+		if (accelDuration > duration)
+			duration = accelDuration;
+	}
+
+	return duration;
+}
+
+template <uint8_t N>
+bool IRAM_ATTR ESP32_ISR_ServoT<N>::timerHandler(void* arg)
+{
+	ESP32_ISR_ServoT<N>* engine = (ESP32_ISR_ServoT<N>*) arg;
+
+	engine->run();
+
+	// Yield to the frame task at the end of the ISR, if it has a higher priority than the interrupted one
+	bool yield = (engine->frameWoken == pdTRUE);
+
+	engine->frameWoken = pdFALSE;
+
+	return yield;
+}
+
+template <uint8_t N>
+ESP32_ISR_ServoT<N>::ESP32_ISR_ServoT(const uint8_t& timerNo)
+	: numActive(0), numServos (-1), staggered(ISR_SERVO_STAGGERED_PULSES), grouping(false), playing(false), _timerNo(DEFAULT_ESP32_TIMER_NO), ESP32_ITimer(NULL)
+{
+	frameTask   = NULL;
+	frameWoken  = pdFALSE;
+
+	useTimer(timerNo);
+
+	// Engines on the stack or the heap aren't zeroed: no servo, and frame indexes in range, for any setter called
+	// before init(). No LEDC channel to release either
+	activeFrame   = 0;
+	readyFrame    = 1;
+	backFrame     = 2;
+	numSubframes  = 1;
+	numMoving     = 0;
+
+	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	{
+		servo[servoIndex].count   = 0;
+		servo[servoIndex].enabled = false;
+		servo[servoIndex].pin     = ESP32_WRONG_PIN;
+		servo[servoIndex].backend = ISR_SERVO_BACKEND_ISR;
+		servo[servoIndex].channel = ISR_SERVO_NO_CHANNEL;
+		servo[servoIndex].pulses  = 1;
+	}
+
+	memset((void*) motion, 0, sizeof(motion));
+	memset((void*) idle, 0, sizeof(idle));
+
+#if ISR_SERVO_FAILSAFE
+	memset((void*) failsafe, 0, sizeof(failsafe));
+#endif
+}
+
+// Start of a new frame: swap in the frame published since the last one, if any
+template <uint8_t N>
+void IRAM_ATTR ESP32_ISR_ServoT<N>::startFrame()
 {
+	// Lock-free, the setters never wait for the ISR and the ISR never waits for the setters
+	if (__atomic_load_n(&readyFrame, __ATOMIC_ACQUIRE) & ISR_SERVO_FRAME_NEW)
+	{
+		activeFrame = __atomic_exchange_n(&readyFrame, activeFrame, __ATOMIC_ACQ_REL) & ~ISR_SERVO_FRAME_NEW;
+	}
+
+	edgeCursor = 0;
+	subframe   = 1;
+
+	__atomic_store_n(&frameCount, frameCount + 1, __ATOMIC_RELAXED);
+
+	updateTimeouts();
+
+	TaskHandle_t task = __atomic_load_n(&frameTask, __ATOMIC_ACQUIRE);
+
+	if (task)
+		vTaskNotifyGiveFromISR(task, &frameWoken);
 }
 
-void IRAM_ATTR ESP32_ISR_Servo::run()
+#if ISR_SERVO_USING_EDGE_SCHEDULING
+
+// Called at each alarm of the free-running timer. Handles every edge already due, then re-arms the alarm
+// to the next pending edge, so the ISR only fires at the start of each frame and once per distinct edge
+template <uint8_t N>
+void IRAM_ATTR ESP32_ISR_ServoT<N>::run()
 {
-	static int servoIndex;
+#if (ISR_SERVO_TRACE || ISR_SERVO_STATS)
+	const uint32_t startCycles = cpu_hal_get_cycle_count();
+#endif
+
+	uint64_t now = ESP32_ITimer->getCounterInISR();
 
-	// ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
-	portENTER_CRITICAL_ISR(&timerMux);
+#if ISR_SERVO_STATS
+	// Timer ticks from the alarm to now
+	const uint32_t latency = (now > nextEdgeAt) ? now - nextEdgeAt : 0;
+#endif
 
-	for (servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	while (nextEdgeAt <= now + ISR_SERVO_US_TO_COUNT(ISR_SERVO_EDGE_GUARD_US))
 	{
-		if ( servo[servoIndex].enabled  && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+		// Edge is due within the guard time, wait for it here
+		while (now < nextEdgeAt)
+			now = ESP32_ITimer->getCounterInISR();
+
+		checkSubframe();
+
+		if (edgeCursor < frames[activeFrame].numEdges)
 		{
-			if ( timerCount == servo[servoIndex].count )
-			{
-				// PWM to LOW, will be HIGH again when timerCount = 1
-				digitalWrite(servo[servoIndex].pin, LOW);
-			}
-			else if (timerCount == 1)
+			const edge_t& edge = frames[activeFrame].edges[edgeCursor++];
+
+			applyEdge(edge);
+		}
+		else
+		{
+			// End of frame, which is also the start of the next one
+			frameStartAt = nextEdgeAt;
+
+			startFrame();
+		}
+
+		skipMaskedEdges();
+
+		const frame_t& frame = frames[activeFrame];
+
+		nextEdgeAt = frameStartAt + ( (edgeCursor < frame.numEdges) ? frame.edges[edgeCursor].at :
+		                              ISR_SERVO_US_TO_COUNT(REFRESH_INTERVAL) );
+
+		// Edges at the same time, such as all rising edges at the start of frame, are handled without reading the counter
+		if (nextEdgeAt > now)
+			now = ESP32_ITimer->getCounterInISR();
+	}
+
+	ESP32_ITimer->setAlarmInISR(nextEdgeAt);
+
+#if ISR_SERVO_TRACE
+	traceIsr(startCycles);
+#endif
+
+#if ISR_SERVO_STATS
+	updateStats(startCycles, latency);
+#endif
+}
+
+#else
+
+// Called every TIMER_INTERVAL_MICRO. Only compares timerCount with the next pending edge of the frame
+template <uint8_t N>
+void IRAM_ATTR ESP32_ISR_ServoT<N>::run()
+{
+#if (ISR_SERVO_TRACE || ISR_SERVO_STATS)
+	const uint32_t startCycles = cpu_hal_get_cycle_count();
+#endif
+
+	if (timerCount == 1)
+		startFrame();
+
+	// timerCount starts at 1 => edges at count (timerCount - 1) from the start of frame are due
+	while ( (edgeCursor < frames[activeFrame].numEdges) && (frames[activeFrame].edges[edgeCursor].at < timerCount) )
+	{
+		checkSubframe();
+
+		const edge_t& edge = frames[activeFrame].edges[edgeCursor++];
+
+		applyEdge(edge);
+	}
+
+	// Reset when reaching 20000us / 12us = 1666
+	if (timerCount++ >= REFRESH_INTERVAL / TIMER_INTERVAL_MICRO)
+	{
+		timerCount = 1;
+	}
+
+#if ISR_SERVO_TRACE
+	traceIsr(startCycles);
+#endif
+
+#if ISR_SERVO_STATS
+	// Latency from the period between runs
+	updateStats(startCycles, 0);
+#endif
+}
+
+#endif    // ISR_SERVO_USING_EDGE_SCHEDULING
+
+// The edge of frame at count 'at' from the start of frame, inserted if none yet. NULL if the frame is full.
+// Edges are kept sorted by time, and edges at the same time are merged into one, applied by the same register writes
+template <uint8_t N>
+typename ESP32_ISR_ServoT<N>::edge_t* ESP32_ISR_ServoT<N>::findEdge(frame_t& frame, const uint32_t& at)
+{
+	// Insertion sort, at most FRAME_EDGES entries
+	int edgeIndex = frame.numEdges;
+
+	while ( (edgeIndex > 0) && (frame.edges[edgeIndex - 1].at > at) )
+		edgeIndex--;
+
+	if ( (edgeIndex == 0) || (frame.edges[edgeIndex - 1].at != at) )
+	{
+		// Never with the pulses checked by fitsFrame()
+		if (frame.numEdges >= FRAME_EDGES)
+			return NULL;
+
+		for (int index = frame.numEdges; index > edgeIndex; index--)
+			frame.edges[index] = frame.edges[index - 1];
+
+		memset(&frame.edges[edgeIndex], 0, sizeof(edge_t));
+
+		frame.edges[edgeIndex].at = at;
+
+		frame.numEdges++;
+		edgeIndex++;
+	}
+
+	return &frame.edges[edgeIndex - 1];
+}
+
+// Insert into frame a rising or falling edge of pin, at count 'at' from the start of frame
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::addEdge(frame_t& frame, const uint32_t& at, const uint8_t& pin, const bool& rising)
+{
+	edge_t* edge = findEdge(frame, at);
+
+	if (!edge)
+		return;
+
+	if (rising)
+		edge->setMask[ISR_SERVO_GPIO_BANK(pin)]   |= ISR_SERVO_GPIO_MASK(pin);
+	else
+		edge->clearMask[ISR_SERVO_GPIO_BANK(pin)] |= ISR_SERVO_GPIO_MASK(pin);
+}
+
+// Start of the pulse of servoIndex from the start of its period, length microsecs, in microsecs: a subframe of the ISR
+// frame, or REFRESH_INTERVAL on a LEDC channel. Always 0 if not staggered
+template <uint8_t N>
+uint32_t ESP32_ISR_ServoT<N>::getOffset(const uint8_t& servoIndex, const uint32_t& length)
+{
+	uint32_t offset = 0;
+
+	if (staggered && (servo[servoIndex].max < length))
+	{
+		// Fixed offset per slot, so each servo keeps an exact period.
+		// Pulse must still end before the end of the period, even at its max pulse width
+		offset = servoIndex * ISR_SERVO_STAGGER_STEP;
+
+		if (offset + servo[servoIndex].max >= length)
+			offset = length - servo[servoIndex].max - 1;
+	}
+
+	return offset;
+}
+
+// true if servoIndex, with pulses per REFRESH_INTERVAL up to max pulse width, fits in the frame next to the other
+// active servos: all pulses per REFRESH_INTERVAL divide the largest one, the subframes, within ISR_SERVO_EXTRA_PULSES,
+// and every pulse ends before the end of its subframe
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::fitsFrame(const uint8_t& servoIndex, const uint8_t& pulses, const uint16_t& max)
+{
+	uint8_t   subframes = pulses;
+	uint16_t  extra     = pulses - 1;
+	uint16_t  maxWidth  = max;
+
+	for (int activeIndex = 0; activeIndex < numActive; activeIndex++)
+	{
+		const servo_t& other = servo[activeServo[activeIndex]];
+
+		if (activeServo[activeIndex] == servoIndex)
+			continue;
+
+		subframes = (other.pulses > subframes) ? other.pulses : subframes;
+		extra    += other.pulses - 1;
+		maxWidth  = (other.max > maxWidth) ? other.max : maxWidth;
+	}
+
+	// Also in counts, the shortest subframe being ISR_SERVO_US_TO_COUNT(REFRESH_INTERVAL) / subframes
+	if ( (extra > ISR_SERVO_EXTRA_PULSES) || (maxWidth >= REFRESH_INTERVAL / subframes) || (subframes % pulses) ||
+	     (ISR_SERVO_US_TO_COUNT(maxWidth) >= ISR_SERVO_US_TO_COUNT(REFRESH_INTERVAL) / subframes) )
+		return false;
+
+	for (int activeIndex = 0; activeIndex < numActive; activeIndex++)
+	{
+		if (subframes % servo[activeServo[activeIndex]].pulses)
+			return false;
+	}
+
+	return true;
+}
+
+// Rebuild the dense index of the servos in the frame, after a servo is set up, deleted, enabled or disabled
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::updateActive()
+{
+	numActive     = 0;
+	numSubframes  = 1;
+
+	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	{
+		// Servos on LEDC or RMT channels are not in the frame, nor a faster servo enabled again with no room left
+		if ( servo[servoIndex].enabled  && (servo[servoIndex].pin <= ESP32_MAX_PIN)
+		     && (servo[servoIndex].backend == ISR_SERVO_BACKEND_ISR)
+		     && fitsFrame(servoIndex, servo[servoIndex].pulses, servo[servoIndex].max) )
+		{
+			activeServo[numActive++] = servoIndex;
+
+			if (servo[servoIndex].pulses > numSubframes)
+				numSubframes = servo[servoIndex].pulses;
+		}
+	}
+}
+
+// Rebuild the frame owned by the setters from the active servos, then publish it to be swapped in at the next frame boundary
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::updateFrame()
+{
+	// Deferred to commitUpdate()
+	if (grouping)
+	{
+		groupFrame = true;
+
+		return;
+	}
+
+	frame_t& frame = frames[backFrame];
+
+	uint32_t subframeAt[ISR_SERVO_MAX_PULSES_PER_FRAME];
+
+	frame.numEdges      = 0;
+	frame.numSubframes  = numSubframes;
+	subframeAt[0]       = 0;
+
+	frame.numTimeouts   = 0;
+
+	// Empty edges at the subframe boundaries, merged with the pulses starting there
+	for (int subframeIndex = 1; subframeIndex < numSubframes; subframeIndex++)
+	{
+		subframeAt[subframeIndex] = subframeIndex * ISR_SERVO_US_TO_COUNT(REFRESH_INTERVAL) / numSubframes;
+
+		memset(&frame.edges[frame.numEdges], 0, sizeof(edge_t));
+		frame.edges[frame.numEdges++].at = subframeAt[subframeIndex];
+	}
+
+	for (int activeIndex = 0; activeIndex < numActive; activeIndex++)
+	{
+		const uint8_t   servoIndex  = activeServo[activeIndex];
+		const uint8_t   pulses      = servo[servoIndex].pulses;
+		const uint8_t   every       = (pulses == 1) ? numSubframes : numSubframes / pulses;
+
+		const uint32_t  offset      = ISR_SERVO_US_TO_COUNT(getOffset(servoIndex, REFRESH_INTERVAL / numSubframes));
+
+		// Staggered slower servos also spread over the subframes
+		uint8_t subframeIndex = staggered ? servoIndex % every : 0;
+
+		for (int pulse = 0; pulse < pulses; pulse++, subframeIndex += every)
+		{
+			uint32_t at = subframeAt[subframeIndex] + offset;
+
+			// A max pulse must end at least one count before the end of its subframe: a falling edge at the boundary
+			// is skipped when the ISR swaps in a new frame there, and at the end of the frame never due in tick mode.
+			// The offsets clamped in uS may still get there once truncated to counts. Start such a pulse earlier
+			const uint32_t subframeEnd  = (subframeIndex + 1 < numSubframes) ? subframeAt[subframeIndex + 1] :
+			                              ISR_SERVO_US_TO_COUNT(REFRESH_INTERVAL);
+			const uint32_t maxCount     = ISR_SERVO_US_TO_COUNT(servo[servoIndex].max);
+
+			if (at + maxCount >= subframeEnd)
+				at = subframeEnd - 1 - maxCount;
+
+			// PWM to HIGH at offset in the subframe, LOW again count later
+			addEdge(frame, at, servo[servoIndex].pin, true);
+			addEdge(frame, at + servo[servoIndex].count, servo[servoIndex].pin, false);
+
+#if ISR_SERVO_FAILSAFE
+			// Or parkCount later, once timed out
+			if (failsafe[servoIndex].action == ISR_SERVO_FAILSAFE_PARK)
 			{
-				// PWM to HIGH, will be LOW again when timerCount = servo[servoIndex].count
-				digitalWrite(servo[servoIndex].pin, HIGH);
+				edge_t* edge = findEdge(frame, at + failsafe[servoIndex].parkCount);
+
+				if (edge)
+					edge->parkMask[ISR_SERVO_GPIO_BANK(servo[servoIndex].pin)] |= ISR_SERVO_GPIO_MASK(servo[servoIndex].pin);
 			}
+#endif
+		}
+
+#if ISR_SERVO_FAILSAFE
+		const uint8_t action = failsafe[servoIndex].action;
+#else
+		const uint8_t action = ISR_SERVO_FAILSAFE_OFF;
+#endif
+
+		// Timeouts checked by the ISR
+		if ( idle[servoIndex].frames || (action != ISR_SERVO_FAILSAFE_OFF) )
+		{
+			frame_timeout_t& entry = frame.timeouts[frame.numTimeouts++];
+
+			entry.mask        = ISR_SERVO_GPIO_MASK(servo[servoIndex].pin);
+			entry.bank        = ISR_SERVO_GPIO_BANK(servo[servoIndex].pin);
+			entry.servoIndex  = servoIndex;
+			entry.action      = action;
+			entry.idle        = (idle[servoIndex].frames != 0);
 		}
 	}
 
-	// Reset when reaching 20000us / 10us = 2000
-	if (timerCount++ >= REFRESH_INTERVAL / TIMER_INTERVAL_MICRO)
+	// Edge at the start of each subframe, for the ISR to switch frames there
+	uint16_t edgeIndex = 0;
+
+	frame.subframeEdge[0] = 0;
+
+	for (int subframeIndex = 1; subframeIndex < numSubframes; subframeIndex++)
 	{
-		ISR_SERVO_LOGDEBUG("Reset count");
+		while (frame.edges[edgeIndex].at < subframeAt[subframeIndex])
+			edgeIndex++;
 
-		timerCount = 1;
+		frame.subframeEdge[subframeIndex] = edgeIndex;
 	}
 
-	// ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
-	portEXIT_CRITICAL_ISR(&timerMux);
+	// Publish, and take back either the previously published frame the ISR hasn't picked up yet, or the one it just released
+	backFrame = __atomic_exchange_n(&readyFrame, backFrame | ISR_SERVO_FRAME_NEW, __ATOMIC_ACQ_REL) & ~ISR_SERVO_FRAME_NEW;
+
+	ISR_SERVO_LOGDEBUG1("New frame, edges =", frame.numEdges);
 }
 
-// find the first available slot
-// return -1 if none found
-int8_t ESP32_ISR_Servo::findFirstFreeSlot()
+// Grab a free LEDC channel and route pin to it, with the shared LEDC timer running at 1 / REFRESH_INTERVAL
+// return the channel, or -1 if none available
+template <uint8_t N>
+int8_t ESP32_ISR_ServoT<N>::attachLEDC(const uint8_t& pin)
 {
-	// all slots are used
-	if (numServos >= MAX_SERVOS)
+	int8_t channelIndex;
+
+	for (channelIndex = 0; channelIndex < ISR_SERVO_LEDC_CHANNELS; channelIndex++)
+	{
+		if ( (ledcChannels & (1UL << channelIndex)) == 0 )
+			break;
+	}
+
+	if (channelIndex >= ISR_SERVO_LEDC_CHANNELS)
 		return -1;
 
-	// return the first slot with no count (i.e. free)
-	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	if (!ledcTimerOK)
+	{
+		ledc_timer_config_t ledcTimer;
+
+		memset(&ledcTimer, 0, sizeof(ledcTimer));
+
+		ledcTimer.speed_mode      = LEDC_LOW_SPEED_MODE;
+		ledcTimer.duty_resolution = (ledc_timer_bit_t) ISR_SERVO_LEDC_RESOLUTION;
+		ledcTimer.timer_num       = (ledc_timer_t) ISR_SERVO_LEDC_TIMER;
+		ledcTimer.freq_hz         = 1000000UL / REFRESH_INTERVAL;
+		ledcTimer.clk_cfg         = LEDC_AUTO_CLK;
+
+		if (ledc_timer_config(&ledcTimer) != ESP_OK)
+		{
+			ISR_SERVO_LOGERROR("Fail setup LEDC timer");
+
+			return -1;
+		}
+
+		ledcTimerOK = true;
+	}
+
+	ledc_channel_config_t ledcChannel;
+
+	memset(&ledcChannel, 0, sizeof(ledcChannel));
+
+	ledcChannel.gpio_num    = pin;
+	ledcChannel.speed_mode  = LEDC_LOW_SPEED_MODE;
+	ledcChannel.channel     = (ledc_channel_t) (ISR_SERVO_LEDC_FIRST_CHANNEL + channelIndex);
+	ledcChannel.intr_type   = LEDC_INTR_DISABLE;
+	ledcChannel.timer_sel   = (ledc_timer_t) ISR_SERVO_LEDC_TIMER;
+	ledcChannel.duty        = 0;
+	ledcChannel.hpoint      = 0;
+
+	if (ledc_channel_config(&ledcChannel) != ESP_OK)
+	{
+		ISR_SERVO_LOGERROR1("Fail setup LEDC channel", ledcChannel.channel);
+
+		return -1;
+	}
+
+	ledcChannels |= (1UL << channelIndex);
+
+	ISR_SERVO_LOGDEBUG3("LEDC channel =", ledcChannel.channel, ", pin =", pin);
+
+	return ISR_SERVO_LEDC_FIRST_CHANNEL + channelIndex;
+}
+
+// Stop the LEDC channel of servoIndex with its output LOW, and release the channel
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::detachLEDC(const uint8_t& servoIndex)
+{
+	uint8_t channel = servo[servoIndex].channel;
+
+	ledc_stop(LEDC_LOW_SPEED_MODE, (ledc_channel_t) channel, 0);
+
+	ledcChannels &= ~(1UL << (channel - ISR_SERVO_LEDC_FIRST_CHANNEL));
+}
+
+// Program the duty (pulse width) and hpoint (stagger offset) of the LEDC channel of servoIndex.
+// Duty 0 keeps the output LOW while the servo is disabled
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::updateLEDC(const uint8_t& servoIndex)
+{
+	uint32_t duty   = 0;
+	uint32_t hpoint = 0;
+
+	if (servo[servoIndex].enabled)
+	{
+		// Scale from nanosecs to LEDC ticks, (1 << ISR_SERVO_LEDC_RESOLUTION) per REFRESH_INTERVAL.
+		// Not from servo count, as REFRESH_INTERVAL isn't a whole number of TIMER_INTERVAL_MICRO
+		duty    = ( ( (uint64_t) ISR_SERVO_COUNT_TO_NS(servo[servoIndex].count) << ISR_SERVO_LEDC_RESOLUTION ) +
+		            REFRESH_INTERVAL * 500UL ) / (REFRESH_INTERVAL * 1000UL);
+		// Over its own period, whatever the subframes of the ISR frame
+		hpoint  = ( (uint64_t) getOffset(servoIndex, REFRESH_INTERVAL) << ISR_SERVO_LEDC_RESOLUTION ) / REFRESH_INTERVAL;
+	}
+
+	ledc_set_duty_with_hpoint(LEDC_LOW_SPEED_MODE, (ledc_channel_t) servo[servoIndex].channel, duty, hpoint);
+	ledc_update_duty(LEDC_LOW_SPEED_MODE, (ledc_channel_t) servo[servoIndex].channel);
+}
+
+// Grab a free RMT TX channel and start looping a LOW frame on pin, with the pulse in item 0 only.
+// return the channel, or -1 if none available
+template <uint8_t N>
+int8_t ESP32_ISR_ServoT<N>::attachRMT(const uint8_t& pin, const uint16_t& period)
+{
+	int8_t channelIndex;
+
+	for (channelIndex = 0; channelIndex < ISR_SERVO_RMT_CHANNELS; channelIndex++)
+	{
+		if ( (rmtChannels & (1UL << channelIndex)) == 0 )
+			break;
+	}
+
+	if (channelIndex >= ISR_SERVO_RMT_CHANNELS)
+		return -1;
+
+	rmt_channel_t channel = (rmt_channel_t) (ISR_SERVO_RMT_FIRST_CHANNEL + channelIndex);
+	rmt_config_t  rmtConfig;
+
+	memset(&rmtConfig, 0, sizeof(rmtConfig));
+
+	rmtConfig.rmt_mode                  = RMT_MODE_TX;
+	rmtConfig.channel                   = channel;
+	rmtConfig.gpio_num                  = (gpio_num_t) pin;
+	rmtConfig.clk_div                   = ISR_SERVO_RMT_CLK_DIV;
+	rmtConfig.mem_block_num             = 1;
+	rmtConfig.tx_config.loop_en         = true;
+	rmtConfig.tx_config.idle_level      = RMT_IDLE_LEVEL_LOW;
+	rmtConfig.tx_config.idle_output_en  = true;
+
+	if (rmt_config(&rmtConfig) != ESP_OK)
+	{
+		ISR_SERVO_LOGERROR1("Fail setup RMT channel", channel);
+
+		return -1;
+	}
+
+	// Item 0 is the head, LOW until updateRMT(). Then LOW until period, split into items
+	// short enough for the 15-bit durations, and a 0 duration as end marker to loop back to item 0
+	rmt_item32_t items[REFRESH_INTERVAL / ISR_SERVO_RMT_HEAD_US + 2];
+	uint32_t     low        = (period - ISR_SERVO_RMT_HEAD_US) * ISR_SERVO_RMT_TICKS_PER_US;
+	uint16_t     itemIndex  = 1;
+	bool         secondHalf = false;
+
+	memset(items, 0, sizeof(items));
+
+	items[0].duration0 = ISR_SERVO_RMT_HEAD_US * ISR_SERVO_RMT_TICKS_PER_US / 2;
+	items[0].duration1 = ISR_SERVO_RMT_HEAD_US * ISR_SERVO_RMT_TICKS_PER_US / 2;
+
+	while (low > 0)
+	{
+		uint32_t duration = (low > ISR_SERVO_RMT_HEAD_US * ISR_SERVO_RMT_TICKS_PER_US) ?
+		                    ISR_SERVO_RMT_HEAD_US * ISR_SERVO_RMT_TICKS_PER_US : low;
+
+		if (secondHalf)
+			items[itemIndex++].duration1 = duration;
+		else
+			items[itemIndex].duration0 = duration;
+
+		secondHalf = !secondHalf;
+		low       -= duration;
+	}
+
+	// Ending on a first half leaves duration1 = 0 as end marker, otherwise add one
+	itemIndex++;
+
+	rmt_fill_tx_items(channel, items, itemIndex, 0);
+	rmt_tx_start(channel, true);
+
+	rmtChannels |= (1UL << channelIndex);
+
+	ISR_SERVO_LOGDEBUG3("RMT channel =", channel, ", pin =", pin);
+
+	return channel;
+}
+
+// Stop the RMT channel of servoIndex, back to its idle LOW output, and release the channel
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::detachRMT(const uint8_t& servoIndex)
+{
+	uint8_t channel = servo[servoIndex].channel;
+
+	rmt_tx_stop((rmt_channel_t) channel);
+
+	rmtChannels &= ~(1UL << (channel - ISR_SERVO_RMT_FIRST_CHANNEL));
+}
+
+// Rewrite only item 0 of the looping RMT frame of servoIndex: HIGH for the pulse width, then LOW.
+// It's a single 32-bit word, picked up by the RMT when it starts the next frame, never half-updated
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::updateRMT(const uint8_t& servoIndex)
+{
+	const uint32_t headTicks = ISR_SERVO_RMT_HEAD_US * ISR_SERVO_RMT_TICKS_PER_US;
+
+	rmt_item32_t head;
+	uint32_t     pulseTicks = 0;
+
+	if (servo[servoIndex].enabled)
+	{
+		pulseTicks = ISR_SERVO_COUNT_TO_NS(servo[servoIndex].count) * ISR_SERVO_RMT_TICKS_PER_US / 1000;
+
+		if (pulseTicks >= headTicks)
+			pulseTicks = headTicks - 1;
+	}
+
+	head.val = 0;
+
+	if (pulseTicks > 0)
+	{
+		head.duration0  = pulseTicks;
+		head.level0     = 1;
+		head.duration1  = headTicks - pulseTicks;
+		head.level1     = 0;
+	}
+	else
+	{
+		// Disabled => LOW, still headTicks long as a 0 duration would end the frame
+		head.duration0  = headTicks / 2;
+		head.duration1  = headTicks - headTicks / 2;
+	}
+
+	rmt_fill_tx_items((rmt_channel_t) servo[servoIndex].channel, &head, 1, 0);
+}
+
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::detachChannel(const uint8_t& servoIndex)
+{
+	if (servo[servoIndex].backend == ISR_SERVO_BACKEND_LEDC)
+		detachLEDC(servoIndex);
+	else if (servo[servoIndex].backend == ISR_SERVO_BACKEND_RMT)
+		detachRMT(servoIndex);
+
+	servo[servoIndex].backend = ISR_SERVO_BACKEND_ISR;
+	servo[servoIndex].channel = ISR_SERVO_NO_CHANNEL;
+}
+
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::updateServo(const uint8_t& servoIndex)
+{
+	// Any command restarts the timeouts, from the start of the next frame
+	if (idle[servoIndex].frames)
+	{
+		__atomic_store_n(&idle[servoIndex].deadline,
+		                 __atomic_load_n(&frameCount, __ATOMIC_RELAXED) + idle[servoIndex].frames + 1, __ATOMIC_RELEASE);
+	}
+
+#if ISR_SERVO_FAILSAFE
+	feed(servoIndex);
+#endif
+
+	// Hardware channels deferred to commitUpdate(), the frame by updateFrame()
+	if ( grouping && (servo[servoIndex].backend != ISR_SERVO_BACKEND_ISR) )
+	{
+		groupChannels[servoIndex] = true;
+
+		return;
+	}
+
+	if (servo[servoIndex].backend == ISR_SERVO_BACKEND_LEDC)
+		updateLEDC(servoIndex);
+	else if (servo[servoIndex].backend == ISR_SERVO_BACKEND_RMT)
+		updateRMT(servoIndex);
+	else
+		updateFrame();
+}
+
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::updateAll()
+{
+	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	{
+		if (servo[servoIndex].backend != ISR_SERVO_BACKEND_ISR)
+			updateServo(servoIndex);
+	}
+
+	updateFrame();
+}
+
+// Hold back all changes until commitUpdate()
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::beginUpdate()
+{
+	if (!grouping)
+	{
+		memset(groupChannels, 0, sizeof(groupChannels));
+		groupFrame  = false;
+		grouping    = true;
+	}
+}
+
+// Publish all changes since beginUpdate() together: one frame for the ISR servos, then the LEDC / RMT channels
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::commitUpdate()
+{
+	if (!grouping)
+		return;
+
+	grouping = false;
+
+	if (groupFrame)
+		updateFrame();
+
+	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	{
+		if (groupChannels[servoIndex])
+			updateServo(servoIndex);
+	}
+}
+
+#if ISR_SERVO_STATS
+
+// Retry until no ISR run updated the counters while copying them
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::getStats(isr_servo_stats_t& stats)
+{
+	uint32_t seq;
+
+	do
+	{
+		seq = __atomic_load_n(&statsSeq, __ATOMIC_ACQUIRE);
+
+		memcpy(&stats, (const void*) &isrStats, sizeof(stats));
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ( (seq & 1) || (seq != __atomic_load_n(&statsSeq, __ATOMIC_RELAXED)) );
+
+	if (numServos < 0)
+		memset(&stats, 0, sizeof(stats));
+	else if (stats.isrCalls > 0)
+		stats.isrCyclesAvg = stats.isrCyclesTotal / stats.isrCalls;
+	else
+		stats.isrCyclesMin = 0;
+}
+
+#endif
+
+#if ISR_SERVO_TRACE
+
+// Copy the oldest trace entries out of the ring buffer, never blocking the ISR
+template <uint8_t N>
+uint16_t ESP32_ISR_ServoT<N>::readTrace(isr_servo_trace_t* entries, const uint16_t& maxEntries)
+{
+	uint32_t head   = __atomic_load_n(&traceHead, __ATOMIC_ACQUIRE);
+	uint32_t tail   = traceTail;
+	uint16_t count  = 0;
+
+	while ( (tail != head) && (count < maxEntries) )
+		entries[count++] = trace[tail++ & (ISR_SERVO_TRACE_SIZE - 1)];
+
+	// Release the slots to the ISR
+	__atomic_store_n(&traceTail, tail, __ATOMIC_RELEASE);
+
+	return count;
+}
+
+#endif    // ISR_SERVO_TRACE
+
+// Spread the rising edges of the servos across the frame, instead of all at the start of frame
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::setStaggered(const bool& stagger)
+{
+	staggered = stagger;
+
+	if (numServos >= 0)
+		updateAll();
+}
+
+// find the first available slot
+// return -1 if none found
+template <uint8_t N>
+int8_t ESP32_ISR_ServoT<N>::findFirstFreeSlot()
+{
+	// all slots are used
+	if (numServos >= MAX_SERVOS)
+		return -1;
+
+	// return the first slot with no count (i.e. free)
+	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	{
+		if (servo[servoIndex].enabled == false)
+		{
+			ISR_SERVO_LOGDEBUG1("Index =", servoIndex);
+
+			return servoIndex;
+		}
+	}
+
+	// no free slots found
+	return -1;
+}
+
+template <uint8_t N>
+int8_t ESP32_ISR_ServoT<N>::setupServo(const uint8_t& pin, const uint16_t& min, const uint16_t& max,
+                                   const isr_servo_backend_t& backend, const uint16_t& refreshInterval)
+{
+	int servoIndex;
+
+	if ( (pin > ESP32_MAX_PIN) || (ISR_SERVO_GPIO_BANK(pin) >= ISR_SERVO_GPIO_BANKS) )
+		return -1;
+
+	// Pulses per REFRESH_INTERVAL, the period rounded up to REFRESH_INTERVAL / pulses. Range checked before narrowing
+	const uint32_t requested = ( (refreshInterval > 0) && (refreshInterval < REFRESH_INTERVAL) ) ?
+	                           REFRESH_INTERVAL / refreshInterval : 1;
+
+	// LEDC channels share one timer at REFRESH_INTERVAL
+	if ( (requested == 0) || (requested > ISR_SERVO_MAX_PULSES_PER_FRAME) ||
+	     ( (requested > 1) && (backend == ISR_SERVO_BACKEND_LEDC) ) )
+		return -1;
+
+	const uint8_t pulses = requested;
+
+	// Timer not started yet, retried at the next call if it can't be
+	if ( (numServos < 0) && !init() )
+		return -1;
+
+	servoIndex = findFirstFreeSlot();
+
+	if (servoIndex < 0)
+		return -1;
+
+	// Slot may be a disabled servo still holding a LEDC or RMT channel
+	detachChannel(servoIndex);
+
+	int8_t              channel = -1;
+	isr_servo_backend_t usedBackend = ISR_SERVO_BACKEND_ISR;
+
+	if (backend == ISR_SERVO_BACKEND_RMT)
+	{
+		if (REFRESH_INTERVAL / pulses <= ISR_SERVO_RMT_HEAD_US)
+			return -1;
+
+		channel = attachRMT(pin, REFRESH_INTERVAL / pulses);
+
+		// No fallback to the ISR when RMT is explicitly requested
+		if (channel < 0)
+			return -1;
+
+		usedBackend = ISR_SERVO_BACKEND_RMT;
+	}
+	else if ( (backend != ISR_SERVO_BACKEND_ISR) && (pulses == 1) )
+	{
+		channel = attachLEDC(pin);
+
+		// No fallback to the ISR when LEDC is explicitly requested
+		if ( (channel < 0) && (backend == ISR_SERVO_BACKEND_LEDC) )
+			return -1;
+
+		if (channel >= 0)
+			usedBackend = ISR_SERVO_BACKEND_LEDC;
+	}
+
+	if (channel < 0)
+	{
+		// Slot is disabled, so not among the active servos
+		if (!fitsFrame(servoIndex, pulses, max))
+			return -1;
+
+		pinMode(pin, OUTPUT);
+	}
+
+	// Linear from min to max until setCalibration()
+	calibration_t& cal = calibration[servoIndex];
+
+	for (int point = 0; point <= ISR_SERVO_CAL_SEGMENTS; point++)
+	{
+		cal.count[point] = ISR_SERVO_US_TO_COUNT(min) + ( (int32_t) ISR_SERVO_US_TO_COUNT(max) -
+		                                                  (int32_t) ISR_SERVO_US_TO_COUNT(min) ) * point / ISR_SERVO_CAL_SEGMENTS;
+	}
+
+	cal.trimCount = 0;
+	cal.trim      = 0;
+	cal.min       = min;
+	cal.max       = max;
+	cal.reversed  = false;
+
+	servo[servoIndex].pin        = pin;
+	servo[servoIndex].min        = min;
+	servo[servoIndex].max        = max;
+	servo[servoIndex].count      = ISR_SERVO_US_TO_COUNT(min);
+	servo[servoIndex].position   = 0;
+	servo[servoIndex].enabled    = true;
+	servo[servoIndex].backend    = usedBackend;
+	servo[servoIndex].channel    = (channel < 0) ? ISR_SERVO_NO_CHANNEL : channel;
+	servo[servoIndex].pulses     = pulses;
+
+	cancelMotion(servoIndex);
+	motion[servoIndex].maxSpeed  = 0;
+	motion[servoIndex].maxAccel  = 0;
+
+	idle[servoIndex].frames      = 0;
+
+#if ISR_SERVO_FAILSAFE
+	failsafe[servoIndex].action  = ISR_SERVO_FAILSAFE_OFF;
+	failsafe[servoIndex].tripped = false;
+#endif
+
+	updateActive();
+	updateServo(servoIndex);
+
+	numServos++;
+
+	ISR_SERVO_LOGDEBUG3("Index =", servoIndex, ", count =", servo[servoIndex].count);
+	ISR_SERVO_LOGDEBUG3("min =", servo[servoIndex].min, ", max =", servo[servoIndex].max);
+
+	return servoIndex;
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setPosition(const uint8_t& servoIndex, const uint16_t& position)
+{
+	return setPositionCd(servoIndex, (position > 180) ? 18000 : position * 100);
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setPositionCd(const uint8_t& servoIndex, const uint16_t& centidegrees)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return false;
+
+	cancelMotion(servoIndex);
+
+	// Updates interval of existing specified servo
+	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+	{
+		servo[servoIndex].position  = (centidegrees > 18000) ? 18000 : centidegrees;
+		servo[servoIndex].count     = getCount(servoIndex, servo[servoIndex].position);
+
+		updateServo(servoIndex);
+
+		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
+		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+
+		return true;
+	}
+
+	// false return for non-used numServo or bad pin
+	return false;
+}
+
+// returns the engine driving the servo, or ISR_SERVO_BACKEND_AUTO on wrong servoIndex
+template <uint8_t N>
+isr_servo_backend_t ESP32_ISR_ServoT<N>::getBackend(const uint8_t& servoIndex)
+{
+	if ( (servoIndex >= MAX_SERVOS) || (servo[servoIndex].pin > ESP32_MAX_PIN) )
+		return ISR_SERVO_BACKEND_AUTO;
+
+	return (isr_servo_backend_t) servo[servoIndex].backend;
+}
+
+template <uint8_t N>
+uint16_t ESP32_ISR_ServoT<N>::getRefreshInterval(const uint8_t& servoIndex)
+{
+	if ( (servoIndex >= MAX_SERVOS) || (servo[servoIndex].pin > ESP32_MAX_PIN) )
+		return 0;
+
+	return REFRESH_INTERVAL / servo[servoIndex].pulses;
+}
+
+// returns last position in degrees if success, or -1 on wrong servoIndex
+template <uint8_t N>
+int ESP32_ISR_ServoT<N>::getPosition(const uint8_t& servoIndex)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return -1;
+
+	// Updates interval of existing specified servo
+	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+	{
+		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
+		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+
+		return (servo[servoIndex].position + 50) / 100;
+	}
+
+	// return 0 for non-used numServo or bad pin
+	return -1;
+}
+
+// returns last position in centidegrees if success, or -1 on wrong servoIndex
+template <uint8_t N>
+int32_t ESP32_ISR_ServoT<N>::getPositionCd(const uint8_t& servoIndex)
+{
+	if ( (servoIndex >= MAX_SERVOS) || !servo[servoIndex].enabled || (servo[servoIndex].pin > ESP32_MAX_PIN) )
+		return -1;
+
+	return servo[servoIndex].position;
+}
+
+// Count of the calibration at position, clamped to min and max. Divisions by constants only, compiled to multiplications
+template <uint8_t N>
+unsigned long ESP32_ISR_ServoT<N>::getCount(const uint8_t& servoIndex, const uint16_t& centidegrees)
+{
+	const calibration_t& cal = calibration[servoIndex];
+
+	uint16_t  at      = (centidegrees > 18000) ? 18000 : centidegrees;
+
+	if (cal.reversed)
+		at = 18000 - at;
+
+	uint8_t   segment = (at < 18000) ? at / ISR_SERVO_CAL_STEP : ISR_SERVO_CAL_SEGMENTS - 1;
+	int32_t   offset  = at - segment * ISR_SERVO_CAL_STEP;
+	int32_t   delta   = (int32_t) cal.count[segment + 1] - (int32_t) cal.count[segment];
+	int32_t   count   = (int32_t) cal.count[segment] + cal.trimCount +
+	                    ( delta * offset + ( (delta >= 0) ? ISR_SERVO_CAL_STEP / 2 : -ISR_SERVO_CAL_STEP / 2 ) ) / ISR_SERVO_CAL_STEP;
+	int32_t   min     = ISR_SERVO_US_TO_COUNT(servo[servoIndex].min);
+	int32_t   max     = ISR_SERVO_US_TO_COUNT(servo[servoIndex].max);
+
+	return (count < min) ? min : ( (count > max) ? max : count );
+}
+
+// Position in centidegrees of count, by the calibration segment including it
+template <uint8_t N>
+uint16_t ESP32_ISR_ServoT<N>::getPositionAt(const uint8_t& servoIndex, const unsigned long& count)
+{
+	const calibration_t& cal = calibration[servoIndex];
+
+	int32_t   value     = (int32_t) count - cal.trimCount;
+	int32_t   first     = cal.count[0];
+	int32_t   last      = cal.count[ISR_SERVO_CAL_SEGMENTS];
+	bool      ascending = (last >= first);
+	uint16_t  at;
+
+	if (ascending ? (value <= first) : (value >= first))
+		at = 0;
+	else if (ascending ? (value >= last) : (value <= last))
+		at = 18000;
+	else
+	{
+		uint8_t segment = 0;
+
+		// Monotonic table, first segment reaching value
+		while ( (segment < ISR_SERVO_CAL_SEGMENTS - 1) && (ascending ? (value > (int32_t) cal.count[segment + 1]) :
+		                                                   (value < (int32_t) cal.count[segment + 1])) )
+			segment++;
+
+		int32_t delta = (int32_t) cal.count[segment + 1] - (int32_t) cal.count[segment];
+
+		at = segment * ISR_SERVO_CAL_STEP;
+
+		if (delta)
+			at += ( (value - (int32_t) cal.count[segment]) * ISR_SERVO_CAL_STEP + delta / 2 ) / delta;
+	}
+
+	return cal.reversed ? 18000 - at : at;
+}
+
+// min and max of servoIndex from its calibration and trim, if the max pulse width still fits in the frame
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setLimits(const uint8_t& servoIndex, const int16_t& trim)
+{
+	calibration_t& cal = calibration[servoIndex];
+
+	int32_t min = cal.min + trim;
+	int32_t max = cal.max + trim;
+
+	if ( (min <= 0) || (max > 0xFFFF) )
+		return false;
+
+	if ( (servo[servoIndex].channel == ISR_SERVO_NO_CHANNEL) && !fitsFrame(servoIndex, servo[servoIndex].pulses, max) )
+		return false;
+
+	servo[servoIndex].min = min;
+	servo[servoIndex].max = max;
+
+	cal.trim      = trim;
+	cal.trimCount = (trim >= 0) ? (int32_t) ISR_SERVO_US_TO_COUNT(trim) : -(int32_t) ISR_SERVO_US_TO_COUNT(-trim);
+
+	return true;
+}
+
+// Pulse width of the current position, after a change of calibration
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::updateCount(const uint8_t& servoIndex)
+{
+	servo[servoIndex].count = getCount(servoIndex, servo[servoIndex].position);
+
+	if (servo[servoIndex].enabled)
+		updateServo(servoIndex);
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setCalibration(const uint8_t& servoIndex, const uint16_t* pulseWidths, const uint8_t& numPoints)
+{
+	if ( (servoIndex >= MAX_SERVOS) || (servo[servoIndex].pin > ESP32_MAX_PIN) || !pulseWidths || (numPoints < 2) )
+		return false;
+
+	bool      rising  = false;
+	bool      falling = false;
+	uint16_t  min     = pulseWidths[0];
+	uint16_t  max     = pulseWidths[0];
+
+	for (int point = 1; point < numPoints; point++)
+	{
+		rising  = rising  || (pulseWidths[point] > pulseWidths[point - 1]);
+		falling = falling || (pulseWidths[point] < pulseWidths[point - 1]);
+		min     = (pulseWidths[point] < min) ? pulseWidths[point] : min;
+		max     = (pulseWidths[point] > max) ? pulseWidths[point] : max;
+	}
+
+	// Not monotonic
+	if (rising && falling)
+		return false;
+
+	calibration_t previous  = calibration[servoIndex];
+	calibration_t& cal      = calibration[servoIndex];
+
+	// Resample the numPoints - 1 segments into ISR_SERVO_CAL_SEGMENTS
+	for (int point = 0; point <= ISR_SERVO_CAL_SEGMENTS; point++)
+	{
+		uint32_t  at    = point * (numPoints - 1);
+		uint8_t   index = at / ISR_SERVO_CAL_SEGMENTS;
+		int32_t   rest  = at % ISR_SERVO_CAL_SEGMENTS;
+
+		if (index >= numPoints - 1)
+		{
+			index = numPoints - 2;
+			rest  = ISR_SERVO_CAL_SEGMENTS;
+		}
+
+		int32_t from  = ISR_SERVO_US_TO_COUNT(pulseWidths[index]);
+		int32_t to    = ISR_SERVO_US_TO_COUNT(pulseWidths[index + 1]);
+
+		cal.count[point] = from + (to - from) * rest / ISR_SERVO_CAL_SEGMENTS;
+	}
+
+	cal.min = min;
+	cal.max = max;
+
+	if (!setLimits(servoIndex, cal.trim))
+	{
+		calibration[servoIndex] = previous;
+
+		return false;
+	}
+
+	updateCount(servoIndex);
+
+	return true;
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setTrim(const uint8_t& servoIndex, const int16_t& trimUs)
+{
+	if ( (servoIndex >= MAX_SERVOS) || (servo[servoIndex].pin > ESP32_MAX_PIN) || !setLimits(servoIndex, trimUs) )
+		return false;
+
+	updateCount(servoIndex);
+
+	return true;
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setReversed(const uint8_t& servoIndex, const bool& reversed)
+{
+	if ( (servoIndex >= MAX_SERVOS) || (servo[servoIndex].pin > ESP32_MAX_PIN) )
+		return false;
+
+	calibration[servoIndex].reversed = reversed;
+
+	updateCount(servoIndex);
+
+	return true;
+}
+
+
+// setPulseWidth will set servo PWM Pulse Width in microseconds, correcponding to certain position in degrees
+// by using PWM, turn HIGH 'pulseWidth' microseconds within REFRESH_INTERVAL (20000us)
+// min and max for each individual servo are enforced
+// returns true on success or -1 on wrong servoIndex
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setPulseWidth(const uint8_t& servoIndex, uint16_t& pulseWidth)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return false;
+
+	cancelMotion(servoIndex);
+
+	// Updates interval of existing specified servo
+	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+	{
+		if (pulseWidth < servo[servoIndex].min)
+			pulseWidth = servo[servoIndex].min;
+		else if (pulseWidth > servo[servoIndex].max)
+			pulseWidth = servo[servoIndex].max;
+
+		servo[servoIndex].count     = ISR_SERVO_US_TO_COUNT(pulseWidth);
+		servo[servoIndex].position  = getPositionAt(servoIndex, servo[servoIndex].count);
+
+		updateServo(servoIndex);
+
+		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
+		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+
+		return true;
+	}
+
+	// false return for non-used numServo or bad pin
+	return false;
+}
+
+// returns pulseWidth in microsecs (within min/max range) if success, or 0 on wrong servoIndex
+template <uint8_t N>
+unsigned int ESP32_ISR_ServoT<N>::getPulseWidth(const uint8_t& servoIndex)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return 0;
+
+	// Updates interval of existing specified servo
+	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+	{
+		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
+		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+
+		return ISR_SERVO_COUNT_TO_US(servo[servoIndex].count);
+	}
+
+	// return 0 for non-used numServo or bad pin
+	return 0;
+}
+
+// setPulseWidthNs will set servo PWM Pulse Width in nanosecs, stored directly in servo count units
+// min and max for each individual servo are enforced
+// returns true on success or false on wrong servoIndex
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setPulseWidthNs(const uint8_t& servoIndex, uint32_t& pulseWidthNs)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return false;
+
+	cancelMotion(servoIndex);
+
+	// Updates interval of existing specified servo
+	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+	{
+		if (pulseWidthNs < servo[servoIndex].min * 1000UL)
+			pulseWidthNs = servo[servoIndex].min * 1000UL;
+		else if (pulseWidthNs > servo[servoIndex].max * 1000UL)
+			pulseWidthNs = servo[servoIndex].max * 1000UL;
+
+		servo[servoIndex].count     = ISR_SERVO_NS_TO_COUNT(pulseWidthNs);
+		servo[servoIndex].position  = getPositionAt(servoIndex, servo[servoIndex].count);
+
+		updateServo(servoIndex);
+
+		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
+		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+
+		return true;
+	}
+
+	// false return for non-used numServo or bad pin
+	return false;
+}
+
+// returns pulseWidth in nanosecs (within min/max range) if success, or 0 on wrong servoIndex
+template <uint8_t N>
+uint32_t ESP32_ISR_ServoT<N>::getPulseWidthNs(const uint8_t& servoIndex)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return 0;
+
+	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+	{
+		return ISR_SERVO_COUNT_TO_NS(servo[servoIndex].count);
+	}
+
+	// return 0 for non-used numServo or bad pin
+	return 0;
+}
+
+
+// true if every servo of mask is set up and enabled
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::isValidMask(const uint32_t& mask)
+{
+	const uint32_t allServos = (MAX_SERVOS >= 32) ? 0xFFFFFFFFUL : ( (1UL << (MAX_SERVOS & 31)) - 1 );
+
+	if (mask & ~allServos)
+		return false;
+
+	for (uint32_t bits = mask; bits; bits &= bits - 1)
 	{
-		if (servo[servoIndex].enabled == false)
-		{
-			ISR_SERVO_LOGDEBUG1("Index =", servoIndex);
+		uint8_t servoIndex = __builtin_ctz(bits);
 
-			return servoIndex;
-		}
+		if ( !servo[servoIndex].enabled || (servo[servoIndex].pin > ESP32_MAX_PIN) )
+			return false;
 	}
 
-	// no free slots found
-	return -1;
+	return true;
 }
 
-int8_t ESP32_ISR_Servo::setupServo(const uint8_t& pin, const uint16_t& min, const uint16_t& max)
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setPositions(const uint16_t* positions, const uint32_t& mask)
 {
-	int servoIndex;
+	if ( !positions || !isValidMask(mask) )
+		return false;
 
-	if (pin > ESP32_MAX_PIN)
-		return -1;
+	// Joins the group of the caller, if any
+	bool            ownGroup = !grouping;
+	const uint16_t* position = positions;
 
-	if (numServos < 0)
-		init();
+	if (ownGroup)
+		beginUpdate();
 
-	servoIndex = findFirstFreeSlot();
+	for (uint32_t bits = mask; bits; bits &= bits - 1)
+	{
+		uint8_t servoIndex = __builtin_ctz(bits);
 
-	if (servoIndex < 0)
-		return -1;
+		cancelMotion(servoIndex);
 
-	servo[servoIndex].pin        = pin;
-	servo[servoIndex].min        = min;
-	servo[servoIndex].max        = max;
-	servo[servoIndex].count      = min / TIMER_INTERVAL_MICRO;
-	servo[servoIndex].position   = 0;
-	servo[servoIndex].enabled    = true;
+		servo[servoIndex].position  = (*position > 180) ? 18000 : *position * 100;
+		servo[servoIndex].count     = getCount(servoIndex, servo[servoIndex].position);
 
-	pinMode(pin, OUTPUT);
+		updateServo(servoIndex);
 
-	numServos++;
+		position++;
+	}
 
-	ISR_SERVO_LOGDEBUG3("Index =", servoIndex, ", count =", servo[servoIndex].count);
-	ISR_SERVO_LOGDEBUG3("min =", servo[servoIndex].min, ", max =", servo[servoIndex].max);
+	if (ownGroup)
+		commitUpdate();
 
-	return servoIndex;
+	ISR_SERVO_LOGDEBUG1("setPositions, mask =", mask);
+
+	return true;
 }
 
-bool ESP32_ISR_Servo::setPosition(const uint8_t& servoIndex, const uint16_t& position)
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setPulseWidths(const uint16_t* pulseWidths, const uint32_t& mask)
 {
-	if (servoIndex >= MAX_SERVOS)
+	if ( !pulseWidths || !isValidMask(mask) )
 		return false;
 
-	// Updates interval of existing specified servo
-	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+	bool            ownGroup    = !grouping;
+	const uint16_t* pulseWidth  = pulseWidths;
+
+	if (ownGroup)
+		beginUpdate();
+
+	for (uint32_t bits = mask; bits; bits &= bits - 1)
 	{
-		// ESP32 is a multi core / multi processing chip.
-		// It is mandatory to disable task switches during modifying shared vars
-		portENTER_CRITICAL(&timerMux);
+		uint8_t   servoIndex  = __builtin_ctz(bits);
+		uint16_t  width       = *pulseWidth;
 
-		servo[servoIndex].position  = position;
-		servo[servoIndex].count     = map(position, 0, 180, servo[servoIndex].min, servo[servoIndex].max) / TIMER_INTERVAL_MICRO;
+		cancelMotion(servoIndex);
 
-		// ESP32 is a multi core / multi processing chip.
-		// It is mandatory to disable task switches during modifying shared vars
-		portEXIT_CRITICAL(&timerMux);
+		if (width < servo[servoIndex].min)
+			width = servo[servoIndex].min;
+		else if (width > servo[servoIndex].max)
+			width = servo[servoIndex].max;
 
-		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
-		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+		servo[servoIndex].count     = ISR_SERVO_US_TO_COUNT(width);
+		servo[servoIndex].position  = getPositionAt(servoIndex, servo[servoIndex].count);
 
-		return true;
+		updateServo(servoIndex);
+
+		pulseWidth++;
 	}
 
-	// false return for non-used numServo or bad pin
-	return false;
+	if (ownGroup)
+		commitUpdate();
+
+	ISR_SERVO_LOGDEBUG1("setPulseWidths, mask =", mask);
+
+	return true;
 }
 
-// returns last position in degrees if success, or -1 on wrong servoIndex
-int ESP32_ISR_Servo::getPosition(const uint8_t& servoIndex)
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setAutoIdle(const uint8_t& servoIndex, const uint32_t& idleMs)
 {
-	if (servoIndex >= MAX_SERVOS)
-		return -1;
+	if ( (servoIndex >= MAX_SERVOS) || (servo[servoIndex].pin > ESP32_MAX_PIN) ||
+	     (servo[servoIndex].backend != ISR_SERVO_BACKEND_ISR) )
+		return false;
 
-	// Updates interval of existing specified servo
-	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
-	{
-		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
-		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+	// Rounded up to whole frames
+	idle[servoIndex].frames = ( (uint64_t) idleMs * 1000 + REFRESH_INTERVAL - 1 ) / REFRESH_INTERVAL;
 
-		return (servo[servoIndex].position);
-	}
+	// Timeout restarted, and in the frame
+	updateServo(servoIndex);
 
-	// return 0 for non-used numServo or bad pin
-	return -1;
+	ISR_SERVO_LOGDEBUG3("setAutoIdle, Idx =", servoIndex, ", frames =", idle[servoIndex].frames);
+
+	return true;
 }
 
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::isIdle(const uint8_t& servoIndex)
+{
+	if ( (servoIndex >= MAX_SERVOS) || (idle[servoIndex].frames == 0) || !servo[servoIndex].enabled )
+		return false;
 
-// setPulseWidth will set servo PWM Pulse Width in microseconds, correcponding to certain position in degrees
-// by using PWM, turn HIGH 'pulseWidth' microseconds within REFRESH_INTERVAL (20000us)
-// min and max for each individual servo are enforced
-// returns true on success or -1 on wrong servoIndex
-bool ESP32_ISR_Servo::setPulseWidth(const uint8_t& servoIndex, uint16_t& pulseWidth)
+	return ( (int32_t) (__atomic_load_n(&frameCount, __ATOMIC_RELAXED) - idle[servoIndex].deadline) >= 0 );
+}
+
+#if ISR_SERVO_FAILSAFE
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setFailsafe(const uint8_t& servoIndex, const uint32_t& timeoutMs, const uint8_t& action,
+                                      const uint16_t& pulseWidth)
 {
-	if (servoIndex >= MAX_SERVOS)
+	if ( (servoIndex >= MAX_SERVOS) || (servo[servoIndex].pin > ESP32_MAX_PIN) ||
+	     (servo[servoIndex].backend != ISR_SERVO_BACKEND_ISR) || (action > ISR_SERVO_FAILSAFE_STOP) )
 		return false;
 
-	// Updates interval of existing specified servo
-	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
-	{
-		if (pulseWidth < servo[servoIndex].min)
-			pulseWidth = servo[servoIndex].min;
-		else if (pulseWidth > servo[servoIndex].max)
-			pulseWidth = servo[servoIndex].max;
+	failsafe_t& timeout = failsafe[servoIndex];
 
-		// ESP32 is a multi core / multi processing chip.
-		// It is mandatory to disable task switches during modifying shared vars
-		portENTER_CRITICAL(&timerMux);
+	uint16_t width = pulseWidth;
 
-		servo[servoIndex].count     = pulseWidth / TIMER_INTERVAL_MICRO;
-		servo[servoIndex].position  = map(pulseWidth, servo[servoIndex].min, servo[servoIndex].max, 0, 180);
+	if (width < servo[servoIndex].min)
+		width = servo[servoIndex].min;
+	else if (width > servo[servoIndex].max)
+		width = servo[servoIndex].max;
 
-		// ESP32 is a multi core / multi processing chip.
-		// It is mandatory to disable task switches during modifying shared vars
-		portEXIT_CRITICAL(&timerMux);
+	// Rounded up to whole frames
+	timeout.timeoutFrames = ( (uint64_t) timeoutMs * 1000 + REFRESH_INTERVAL - 1 ) / REFRESH_INTERVAL;
+	timeout.parkCount     = ISR_SERVO_US_TO_COUNT(width);
+	timeout.action        = (timeoutMs == 0) ? (uint8_t) ISR_SERVO_FAILSAFE_OFF : action;
 
-		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
-		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+	if (timeout.action == ISR_SERVO_FAILSAFE_OFF)
+		timeout.tripped = false;
 
-		return true;
-	}
+	// Timeout restarted, and the new action in the frame
+	updateServo(servoIndex);
 
-	// false return for non-used numServo or bad pin
-	return false;
+	ISR_SERVO_LOGDEBUG3("setFailsafe, Idx =", servoIndex, ", frames =", timeout.timeoutFrames);
+
+	return true;
 }
 
-// returns pulseWidth in microsecs (within min/max range) if success, or 0 on wrong servoIndex
-unsigned int ESP32_ISR_Servo::getPulseWidth(const uint8_t& servoIndex)
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::feed(const uint8_t& servoIndex)
 {
-	if (servoIndex >= MAX_SERVOS)
-		return 0;
+	if ( (servoIndex >= MAX_SERVOS) || (failsafe[servoIndex].action == ISR_SERVO_FAILSAFE_OFF) )
+		return;
 
-	// Updates interval of existing specified servo
-	if ( servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
-	{
-		ISR_SERVO_LOGERROR1("Idx =", servoIndex);
-		ISR_SERVO_LOGERROR3("cnt =", servo[servoIndex].count, ", pos =", servo[servoIndex].position);
+	// From the start of the next frame, so never before timeoutMs
+	__atomic_store_n(&failsafe[servoIndex].deadline,
+	                 __atomic_load_n(&frameCount, __ATOMIC_RELAXED) + failsafe[servoIndex].timeoutFrames + 1, __ATOMIC_RELEASE);
+}
 
-		return (servo[servoIndex].count * TIMER_INTERVAL_MICRO );
-	}
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::feedAll()
+{
+	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+		feed(servoIndex);
+}
 
-	// return 0 for non-used numServo or bad pin
-	return 0;
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::isFailsafe(const uint8_t& servoIndex)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return false;
+
+	return (failsafe[servoIndex].action != ISR_SERVO_FAILSAFE_OFF) &&
+	       __atomic_load_n(&failsafe[servoIndex].tripped, __ATOMIC_RELAXED);
 }
 
+#endif    // ISR_SERVO_FAILSAFE
 
-void ESP32_ISR_Servo::deleteServo(const uint8_t& servoIndex)
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::deleteServo(const uint8_t& servoIndex)
 {
 	if ( (numServos == 0) || (servoIndex >= MAX_SERVOS) )
 	{
 		return;
 	}
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portENTER_CRITICAL(&timerMux);
-
 	// don't decrease the number of servos if the specified slot is already empty
+	// Also release the LEDC or RMT channel of a disabled servo
+	detachChannel(servoIndex);
+	cancelMotion(servoIndex);
+
 	if (servo[servoIndex].enabled)
 	{
 		memset((void*) &servo[servoIndex], 0, sizeof (servo_t));
@@ -266,17 +1598,19 @@ void ESP32_ISR_Servo::deleteServo(const uint8_t& servoIndex)
 		servo[servoIndex].count     = 0;
 		// Intentional bad pin, good only from 0-16 for Digital, A0=17
 		servo[servoIndex].pin       = ESP32_WRONG_PIN;
+		servo[servoIndex].backend   = ISR_SERVO_BACKEND_ISR;
+		servo[servoIndex].channel   = ISR_SERVO_NO_CHANNEL;
 
 		// update number of servos
 		numServos--;
 	}
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portEXIT_CRITICAL(&timerMux);
+	updateActive();
+	updateFrame();
 }
 
-bool ESP32_ISR_Servo::isEnabled(const uint8_t& servoIndex)
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::isEnabled(const uint8_t& servoIndex)
 {
 	if (servoIndex >= MAX_SERVOS)
 		return false;
@@ -292,36 +1626,34 @@ bool ESP32_ISR_Servo::isEnabled(const uint8_t& servoIndex)
 	return servo[servoIndex].enabled;
 }
 
-bool ESP32_ISR_Servo::enable(const uint8_t& servoIndex)
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::enable(const uint8_t& servoIndex)
 {
 	if (servoIndex >= MAX_SERVOS)
 		return false;
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portENTER_CRITICAL(&timerMux);
-
 	if (servo[servoIndex].pin > ESP32_MAX_PIN)
 	{
 		// Disable if something wrong
 		servo[servoIndex].pin     = ESP32_WRONG_PIN;
 		servo[servoIndex].enabled = false;
+
 		return false;
 	}
 
 	// Bug fix. See "Fixed count >= min comparison for servo enable."
 	// (https://github.com/khoih-prog/ESP32_ISR_Servo/pull/1)
-	if ( servo[servoIndex].count >= servo[servoIndex].min / TIMER_INTERVAL_MICRO )
+	if ( servo[servoIndex].count >= ISR_SERVO_US_TO_COUNT(servo[servoIndex].min) )
 		servo[servoIndex].enabled = true;
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portEXIT_CRITICAL(&timerMux);
+	updateActive();
+	updateServo(servoIndex);
 
 	return true;
 }
 
-bool ESP32_ISR_Servo::disable(const uint8_t& servoIndex)
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::disable(const uint8_t& servoIndex)
 {
 	if (servoIndex >= MAX_SERVOS)
 		return false;
@@ -331,69 +1663,399 @@ bool ESP32_ISR_Servo::disable(const uint8_t& servoIndex)
 
 	servo[servoIndex].enabled = false;
 
+	updateActive();
+	updateServo(servoIndex);
+
 	return true;
 }
 
-void ESP32_ISR_Servo::enableAll()
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::enableAll()
 {
 	// Enable all servos with a enabled and count != 0 (has PWM) and good pin
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portENTER_CRITICAL(&timerMux);
-
 	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
 	{
 		// Bug fix. See "Fixed count >= min comparison for servo enable."
 		// (https://github.com/khoih-prog/ESP32_ISR_Servo/pull/1)
-		if ( (servo[servoIndex].count >= servo[servoIndex].min / TIMER_INTERVAL_MICRO ) && !servo[servoIndex].enabled
+		if ( (servo[servoIndex].count >= ISR_SERVO_US_TO_COUNT(servo[servoIndex].min) ) && !servo[servoIndex].enabled
 		     && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
 		{
 			servo[servoIndex].enabled = true;
 		}
 	}
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portEXIT_CRITICAL(&timerMux);
+	updateActive();
+	updateAll();
 }
 
-void ESP32_ISR_Servo::disableAll()
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::disableAll()
 {
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portENTER_CRITICAL(&timerMux);
-
 	// Disable all servos
 	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
 	{
 		servo[servoIndex].enabled = false;
 	}
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portEXIT_CRITICAL(&timerMux);
+	updateActive();
+	updateAll();
 }
 
-bool ESP32_ISR_Servo::toggle(const uint8_t& servoIndex)
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::toggle(const uint8_t& servoIndex)
 {
 	if (servoIndex >= MAX_SERVOS)
 		return false;
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portENTER_CRITICAL(&timerMux);
-
 	servo[servoIndex].enabled = !servo[servoIndex].enabled;
 
-	// ESP32 is a multi core / multi processing chip.
-	// It is mandatory to disable task switches during modifying shared vars
-	portEXIT_CRITICAL(&timerMux);
+	updateActive();
+	updateServo(servoIndex);
 
 	return true;
 }
 
-int8_t ESP32_ISR_Servo::getNumServos()
+template <uint8_t N>
+int8_t ESP32_ISR_ServoT<N>::getNumServos()
 {
 	return numServos;
 }
+
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::cancelMotion(const uint8_t& servoIndex)
+{
+	if (motion[servoIndex].moving)
+	{
+		motion[servoIndex].moving = false;
+		numMoving--;
+	}
+}
+
+// Duration of a move of servoIndex to position, durationMs stretched to the limits of setMotionLimits()
+template <uint8_t N>
+uint32_t ESP32_ISR_ServoT<N>::getMoveMs(const uint8_t& servoIndex, const uint16_t& position, const uint32_t& durationMs,
+                                        const uint8_t& profile)
+{
+	uint16_t  toPos     = (position > 180) ? 18000 : position * 100;
+	float     distance  = ( (toPos > servo[servoIndex].position) ? toPos - servo[servoIndex].position :
+	                        servo[servoIndex].position - toPos ) / 100.0f;
+	uint32_t  minMs     = 1000 * minDuration(profile, distance, motion[servoIndex].maxSpeed,
+	                                         motion[servoIndex].maxAccel) + 0.5f;
+
+	return (durationMs < minMs) ? minMs : durationMs;
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::moveTo(const uint8_t& servoIndex, const uint16_t& position, const uint32_t& durationMs,
+                                 const isr_servo_profile_t& profile)
+{
+	if ( (servoIndex >= MAX_SERVOS) || !servo[servoIndex].enabled || (servo[servoIndex].pin > ESP32_MAX_PIN) )
+		return false;
+
+	startMove(servoIndex, position, getMoveFrames(getMoveMs(servoIndex, position, durationMs, profile)), profile,
+	          __atomic_load_n(&frameCount, __ATOMIC_RELAXED));
+
+	return true;
+}
+
+// Move all count servos of servoIndexes to their positions together, in the same frames
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::moveGroupTo(const uint8_t* servoIndexes, const uint16_t* positions, const uint8_t& count,
+                                      const uint32_t& durationMs, const isr_servo_profile_t& profile)
+{
+	uint32_t duration = durationMs;
+
+	// Slowest servo sets the pace of all
+	for (int index = 0; index < count; index++)
+	{
+		uint8_t servoIndex = servoIndexes[index];
+
+		if ( (servoIndex >= MAX_SERVOS) || !servo[servoIndex].enabled || (servo[servoIndex].pin > ESP32_MAX_PIN) )
+			return false;
+
+		uint32_t moveMs = getMoveMs(servoIndex, positions[index], durationMs, profile);
+
+		if (moveMs > duration)
+			duration = moveMs;
+	}
+
+	uint32_t numFrames  = getMoveFrames(duration);
+	uint32_t startFrame = __atomic_load_n(&frameCount, __ATOMIC_RELAXED);
+
+	// Joins the group of the caller, if any
+	bool ownGroup = !grouping;
+
+	if (ownGroup)
+		beginUpdate();
+
+	for (int index = 0; index < count; index++)
+		startMove(servoIndexes[index], positions[index], numFrames, profile, startFrame);
+
+	if (ownGroup)
+		commitUpdate();
+
+	return true;
+}
+
+template <uint8_t N>
+uint32_t ESP32_ISR_ServoT<N>::getMoveFrames(const uint32_t& durationMs)
+{
+	return ( (uint64_t) durationMs * 1000 + REFRESH_INTERVAL / 2 ) / REFRESH_INTERVAL;
+}
+
+// Move servoIndex to position from frame startFrame, reaching it numFrames later
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::startMove(const uint8_t& servoIndex, const uint16_t& position, const uint32_t& numFrames,
+                                    const uint8_t& profile, const uint32_t& startFrame)
+{
+	motion_t& move      = motion[servoIndex];
+	uint16_t  toPos     = (position > 180) ? 18000 : position * 100;
+
+	cancelMotion(servoIndex);
+
+	move.fromPosition = servo[servoIndex].position;
+	move.toPosition   = toPos;
+	move.profile      = profile;
+
+	// From the frame now running, reaching the target at the start of frame (startFrame + numFrames)
+	move.startFrame = startFrame;
+	move.numFrames  = numFrames;
+
+	if (move.numFrames == 0)
+	{
+		// Too short for a frame, same as setPosition()
+		servo[servoIndex].position  = toPos;
+		servo[servoIndex].count     = getCount(servoIndex, toPos);
+
+		updateServo(servoIndex);
+
+		return;
+	}
+
+	move.moving = true;
+	numMoving++;
+
+	// Next updateMotion() steps, even within the current frame
+	motionFrame = move.startFrame - 1;
+
+	ISR_SERVO_LOGDEBUG3("moveTo, Idx =", servoIndex, ", frames =", move.numFrames);
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::setMotionLimits(const uint8_t& servoIndex, const uint16_t& maxSpeed, const uint16_t& maxAccel)
+{
+	if (servoIndex >= MAX_SERVOS)
+		return false;
+
+	motion[servoIndex].maxSpeed = maxSpeed;
+	motion[servoIndex].maxAccel = maxAccel;
+
+	return true;
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::isMoving(const uint8_t& servoIndex)
+{
+	return (servoIndex < MAX_SERVOS) && motion[servoIndex].moving;
+}
+
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::stopMotion(const uint8_t& servoIndex)
+{
+	if (servoIndex < MAX_SERVOS)
+		cancelMotion(servoIndex);
+}
+
+// Set every moving servo to its position for the next frame, within the group of updateMotion()
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::stepMotion(const uint32_t& frame)
+{
+	for (int servoIndex = 0; servoIndex < MAX_SERVOS; servoIndex++)
+	{
+		motion_t& move = motion[servoIndex];
+
+		if (!move.moving)
+			continue;
+
+		// Frames from the start of the move to the next frame, the one this update is for
+		uint32_t elapsed = frame + 1 - move.startFrame;
+
+		if (elapsed >= move.numFrames)
+		{
+			servo[servoIndex].position  = move.toPosition;
+
+			cancelMotion(servoIndex);
+		}
+		else
+		{
+			// Along the profile in degrees, the calibration then maps each step to the pulse width
+			float   ratio = profileAt(move.profile, (float) elapsed / move.numFrames);
+			int32_t delta = (int32_t) move.toPosition - (int32_t) move.fromPosition;
+
+			servo[servoIndex].position  = move.fromPosition + (int32_t) lroundf(delta * ratio);
+		}
+
+		servo[servoIndex].count = getCount(servoIndex, servo[servoIndex].position);
+
+		updateServo(servoIndex);
+	}
+}
+
+// Step all moves and the sequence to the next frame, and publish them together
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::updateMotion()
+{
+	uint32_t frame = __atomic_load_n(&frameCount, __ATOMIC_RELAXED);
+
+	if ( ( (numMoving == 0) && !playing ) || (frame == motionFrame) )
+		return (numMoving > 0) || playing;
+
+	motionFrame = frame;
+
+	// Joins the group of the caller, if any
+	bool ownGroup = !grouping;
+
+	if (ownGroup)
+		beginUpdate();
+
+	stepMotion(frame);
+
+	// Moves to the next keyframes start where the previous ones just ended, step them too if already late
+	if (playing && updateSequence(frame))
+	{
+		stepMotion(frame);
+		motionFrame = frame;
+	}
+
+	if (ownGroup)
+		commitUpdate();
+
+	return (numMoving > 0) || playing;
+}
+
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::playSequence(const uint8_t* sequence, const uint32_t& length, const bool& loop,
+                                       const uint16_t& speedPercent, const isr_servo_profile_t& profile)
+{
+	stopSequence();
+
+	if ( !sequence || (length < ISR_SERVO_KEYFRAME_HEADER) )
+		return false;
+
+	this->sequence  = sequence;
+	sequenceLength  = length;
+	playLoop        = loop;
+	playProfile     = profile;
+	playSpeed       = speedPercent ? speedPercent : 100;
+	keyOffset       = 0;
+	keyTimeMs       = 0;
+	keyRemainder    = 0;
+	keyFrame        = __atomic_load_n(&frameCount, __ATOMIC_RELAXED);
+	loopFrame       = keyFrame;
+	playMask        = 0;
+	playing         = true;
+
+	// Next updateMotion() starts the first keyframe, even within the current frame
+	motionFrame     = keyFrame - 1;
+
+	ISR_SERVO_LOGDEBUG1("playSequence, bytes =", length);
+
+	return true;
+}
+
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::stopSequence()
+{
+	if (!playing)
+		return;
+
+	playing = false;
+
+	for (int servoIndex = 0; (servoIndex < MAX_SERVOS) && (servoIndex < 32); servoIndex++)
+	{
+		if (playMask & (1UL << servoIndex))
+			cancelMotion(servoIndex);
+	}
+}
+
+template <uint8_t N>
+void ESP32_ISR_ServoT<N>::setSequenceSpeed(const uint16_t& speedPercent)
+{
+	playSpeed     = speedPercent ? speedPercent : 100;
+	keyRemainder  = 0;
+}
+
+// Start the moves of every keyframe whose previous one is reached by the next frame.
+// returns true if any move was started
+template <uint8_t N>
+bool ESP32_ISR_ServoT<N>::updateSequence(const uint32_t& frame)
+{
+	bool started = false;
+
+	while ( playing && ( (int32_t) (frame + 1 - keyFrame) >= 0 ) )
+	{
+		const uint8_t* key = sequence + keyOffset;
+
+		if ( keyOffset + ISR_SERVO_KEYFRAME_HEADER > sequenceLength )
+		{
+			// End of pass, also stopping a loop with no duration at all
+			if ( !playLoop || (keyFrame == loopFrame) )
+			{
+				playing = false;
+				break;
+			}
+
+			keyOffset = 0;
+			keyTimeMs = 0;
+			loopFrame = keyFrame;
+
+			continue;
+		}
+
+		uint32_t timeMs = key[0] | (key[1] << 8) | (key[2] << 16) | ((uint32_t) key[3] << 24);
+		uint32_t mask   = key[4] | (key[5] << 8) | (key[6] << 16) | ((uint32_t) key[7] << 24);
+		uint32_t size   = ISR_SERVO_KEYFRAME_HEADER + __builtin_popcount(mask);
+
+		if (keyOffset + size > sequenceLength)
+		{
+			// Truncated keyframe, same as the end
+			keyOffset = sequenceLength;
+
+			continue;
+		}
+
+		// Scaled time in REFRESH_INTERVAL * speed units, the remainder carried so long sequences don't drift
+		uint64_t scaled     = (uint64_t) ( (timeMs > keyTimeMs) ? timeMs - keyTimeMs : 0 ) * 1000 * 100 + keyRemainder;
+		uint32_t unit       = (uint32_t) REFRESH_INTERVAL * playSpeed;
+		uint32_t numFrames  = scaled / unit;
+
+		keyRemainder = scaled % unit;
+
+		const uint8_t* position = key + ISR_SERVO_KEYFRAME_HEADER;
+
+		for (int servoIndex = 0; servoIndex < 32; servoIndex++)
+		{
+			if ( !(mask & (1UL << servoIndex)) )
+				continue;
+
+			if ( (servoIndex < MAX_SERVOS) && servo[servoIndex].enabled && (servo[servoIndex].pin <= ESP32_MAX_PIN) )
+			{
+				startMove(servoIndex, *position, numFrames, playProfile, keyFrame);
+				playMask |= (1UL << servoIndex);
+				started = true;
+			}
+
+			position++;
+		}
+
+		keyOffset += size;
+		keyTimeMs  = (timeMs > keyTimeMs) ? timeMs : keyTimeMs;
+		keyFrame  += numFrames;
+	}
+
+	return started;
+}
+
+// All members of the default 16 servos engine, for the files only including ESP32_ISR_Servo.hpp
+template class ESP32_ISR_ServoT<16>;